@@ -22,6 +22,9 @@
 // Create RPC server with max 4 methods
 RpcServer<4> rpc;
 
+// Keep the transport global: it assembles frames across loop() iterations
+RpcSerialTransport transport(Serial);
+
 void setup() {
     Serial.begin(115200);
     while (!Serial) delay(10);
@@ -60,12 +63,10 @@ void setup() {
         return "pong";
     });
     
-    // Register getStatus method
-    rpc.addMethod("getStatus", []() -> JsonVariant {
-        StaticJsonDocument<128> doc;
-        doc["uptime"] = millis();
-        doc["freeMem"] = freeMemory();
-        return doc.as<JsonVariant>();
+    // Register getStatus method (writes its result in place)
+    rpc.addMethod("getStatus", [](JsonObjectConst params, JsonVariant result) {
+        result["uptime"] = millis();
+        result["freeMem"] = freeMemory();
     });
     
     Serial.println("RPC Server Ready!");
@@ -78,15 +79,12 @@ void setup() {
 }
 
 void loop() {
-    // Check for incoming RPC requests
-    if (Serial.available()) {
-        RpcSerialTransport transport(Serial);
-        String response = rpc.handleRequest(transport);
-        
-        // Send response if not a notification
-        if (!response.isEmpty()) {
-            Serial.println(response);
-        }
+    // Check for incoming RPC requests (non-blocking)
+    String response = rpc.handleRequest(transport);
+    
+    // Send response if not a notification
+    if (!response.isEmpty()) {
+        Serial.println(response);
     }
 }
 
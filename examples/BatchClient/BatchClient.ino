@@ -0,0 +1,51 @@
+/**
+ * Batch Client Example - Sensor bridge over Serial
+ * 
+ * Reads a sensor board every second. Instead of one request/response
+ * round trip per value, the calls of each cycle are queued and sent as
+ * one JSON-RPC batch frame; the batch reply is routed back to each
+ * call's callback by id.
+ * 
+ * Hardware:
+ * - Arduino Uno/Mega/Nano or compatible
+ * - Sensor board running BasicServer (readAnalog, setLED)
+ * 
+ * Usage:
+ * 1. Upload BasicServer sketch to the sensor board
+ * 2. Upload this sketch, cross TX/RX and connect GND
+ * 3. Values are read once per second in a single frame
+ */
+
+#include <RpcClient.h>
+#include <RpcSerialTransport.h>
+
+RpcSerialTransport transport(Serial);
+RpcClient rpc(transport);
+
+int light = 0;
+int moisture = 0;
+unsigned long lastCycle = 0;
+
+void setup() {
+    Serial.begin(115200);
+    
+    // Everything queued during one loop() pass goes out at the next poll()
+    rpc.setBatching(true);
+}
+
+void loop() {
+    if (millis() - lastCycle >= 1000) {
+        lastCycle = millis();
+        
+        rpc.callAsync("readAnalog", "{\"pin\":0}", [](RpcResponse& resp) {
+            light = resp.result<int>();
+        });
+        rpc.callAsync("readAnalog", "{\"pin\":1}", [](RpcResponse& resp) {
+            moisture = resp.result<int>();
+        });
+        rpc.notify("setLED", "{\"state\":true}");  // Rides along, no reply
+    }
+    
+    // Sends the queued frame, then fires callbacks as the reply arrives
+    rpc.poll();
+}
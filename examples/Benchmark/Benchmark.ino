@@ -0,0 +1,129 @@
+/**
+ * RPC Arduino Toolkit - Benchmark Suite
+ *
+ * Measures the library on the target board before flashing a fleet:
+ * - RpcServer::handleRequest (String and zero-allocation buffer paths)
+ * - RpcClient::call over an in-memory loopback transport
+ * - Safe mode helpers (RpcSafe)
+ *
+ * For each case it reports calls/sec, p50/p99 latency, heap bytes still
+ * held after the run (a leak check, ESP32/ESP8266 only: memory allocated
+ * and freed within a call does not show) and bytes on the wire.
+ * Allocations per call are counted by the host build of this suite,
+ * test/bench_dispatch.cpp (see "Host Tests" in the README).
+ *
+ * Hardware:
+ * - ESP32 or ESP8266 (heap figures), any board for timings
+ *
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud and read the results
+ */
+
+#define RPC_ENABLE_SAFE_MODE 1
+#include <RpcServer.h>
+#include <RpcClient.h>
+#include <RpcLoopbackTransport.h>
+
+const uint16_t SAMPLES = 200;
+uint32_t latencies[SAMPLES];
+
+RpcServer<8> rpc;
+RpcLoopbackTransport loopback([](const String& request) {
+    return rpc.handleRequest(request);
+});
+RpcClient client(loopback);
+
+const char* ADD_REQUEST = "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":5,\"b\":3},\"id\":1}";
+char out[RPC_MAX_RESPONSE_SIZE];
+
+long freeHeap() {
+#if defined(ESP32) || defined(ESP8266)
+    return ESP.getFreeHeap();
+#else
+    return 0;
+#endif
+}
+
+int compareLatency(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Run fn SAMPLES times and print throughput, latency percentiles and the
+// heap not given back (free heap before minus after, per call)
+template<typename F>
+void measure(const char* label, F fn) {
+    fn();  // Warm-up (first-call allocations are not steady state)
+
+    long heapBefore = freeHeap();
+    unsigned long start = micros();
+    for (uint16_t i = 0; i < SAMPLES; i++) {
+        unsigned long t0 = micros();
+        fn();
+        latencies[i] = micros() - t0;
+    }
+    unsigned long total = micros() - start;
+    long heapAfter = freeHeap();
+
+    qsort(latencies, SAMPLES, sizeof(latencies[0]), compareLatency);
+
+    Serial.print(label);
+    Serial.print(": ");
+    Serial.print(SAMPLES * 1000000.0 / total, 0);
+    Serial.print(" calls/s, p50 ");
+    Serial.print(latencies[SAMPLES / 2]);
+    Serial.print(" us, p99 ");
+    Serial.print(latencies[SAMPLES * 99 / 100]);
+    Serial.print(" us, heap retained/call ");
+    Serial.print((float)(heapBefore - heapAfter) / SAMPLES);
+    Serial.println(" B");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+
+    Serial.println("\n=== RPC Benchmark Suite ===");
+
+    rpc.addMethod("add", [](JsonObjectConst params, JsonVariant result) {
+        result.set((params["a"] | 0) + (params["b"] | 0));
+    });
+
+    // Server dispatch
+    String request(ADD_REQUEST);
+    measure("server String ", [&]() {
+        rpc.handleRequest(request);
+    });
+
+    size_t requestLen = strlen(ADD_REQUEST);
+    measure("server buffer ", [&]() {
+        rpc.handleRequest(ADD_REQUEST, requestLen, out, sizeof(out));
+    });
+
+    // Client round trip through the loopback transport
+    loopback.resetCounters();
+    measure("client call   ", []() {
+        client.call("add", "{\"a\":5,\"b\":3}");
+    });
+    Serial.print("wire bytes/call: ");
+    Serial.print((float)loopback.bytesWritten() / (SAMPLES + 1));
+    Serial.print(" out, ");
+    Serial.print((float)loopback.bytesRead() / (SAMPLES + 1));
+    Serial.println(" in");
+
+    // Safe mode helpers
+    measure("safe string   ", []() {
+        String s = RpcSafe::serializeString("hello");
+        RpcSafe::deserializeString(s);
+    });
+
+    measure("safe bigint   ", []() {
+        String s = RpcSafe::serializeBigInt(9007199254740993LL);
+        RpcSafe::deserializeBigInt(s);
+    });
+}
+
+void loop() {
+}
@@ -0,0 +1,78 @@
+/**
+ * RPC Arduino Toolkit - Wire Codec Benchmark
+ *
+ * Compares JSON and MessagePack for a float-heavy telemetry reply:
+ * bytes on the wire plus encode and decode time per message.
+ *
+ * Hardware:
+ * - ESP32 or ESP8266 (any board with ~4KB free RAM)
+ *
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud and read the results
+ */
+
+#define RPC_ENABLE_MSGPACK 1
+#include <RpcServer.h>
+
+const uint16_t ITERATIONS = 500;
+const uint8_t SAMPLES = 16;
+
+StaticJsonDocument<RPC_JSON_DOC_SIZE> reply;
+StaticJsonDocument<RPC_JSON_DOC_SIZE> decoded;
+char wire[RPC_MAX_RESPONSE_SIZE];
+
+// Typical telemetry reply: a handful of readings plus a sample history
+void buildReply() {
+    reply.clear();
+    reply["jsonrpc"] = "2.0";
+    JsonObject result = reply.createNestedObject("result");
+    result["temperature"] = 21.375;
+    result["humidity"] = 48.25;
+    result["pressure"] = 1013.6;
+    result["uptime"] = 123456789UL;
+    JsonArray history = result.createNestedArray("history");
+    for (uint8_t i = 0; i < SAMPLES; i++) {
+        history.add(20.0 + i * 0.137);
+    }
+    reply["id"] = 42;
+}
+
+void runBenchmark(const char* label, RpcFormat format) {
+    size_t len = 0;
+
+    unsigned long start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        len = RpcCodec::encode(reply, wire, sizeof(wire), format);
+    }
+    float encodeUs = (float)(micros() - start) / ITERATIONS;
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        RpcCodec::decode(decoded, wire, len, format);
+    }
+    float decodeUs = (float)(micros() - start) / ITERATIONS;
+
+    Serial.print(label);
+    Serial.print(": ");
+    Serial.print(len);
+    Serial.print(" bytes, encode ");
+    Serial.print(encodeUs);
+    Serial.print(" us, decode ");
+    Serial.print(decodeUs);
+    Serial.println(" us");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+
+    Serial.println("\n=== RPC Wire Codec Benchmark ===");
+
+    buildReply();
+    runBenchmark("JSON   ", RPC_FORMAT_JSON);
+    runBenchmark("MsgPack", RPC_FORMAT_MSGPACK);
+}
+
+void loop() {
+}
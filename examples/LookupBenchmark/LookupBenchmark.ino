@@ -0,0 +1,84 @@
+/**
+ * RPC Arduino Toolkit - Method Lookup Benchmark
+ *
+ * Measures dispatch latency of RpcServer with 8, 32 and 128 registered
+ * methods. Method lookup goes through a hashed index, so the time per
+ * call should stay flat as the method table grows.
+ *
+ * Hardware:
+ * - ESP32 (the 128-method server needs ~16KB of RAM)
+ *
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud and read the results
+ *
+ * The host version (test/bench_lookup.cpp) runs the same cases; probe
+ * chains and removal are covered by test/test_method_index.cpp.
+ */
+
+#include <RpcServer.h>
+
+const uint16_t ITERATIONS = 2000;
+
+RpcServer<8> rpc8;
+RpcServer<32> rpc32;
+RpcServer<128> rpc128;
+
+char out[128];
+
+template<uint8_t N>
+void registerMethods(RpcServer<N>& rpc) {
+    char name[16];
+    for (uint8_t i = 0; i < N; i++) {
+        snprintf(name, sizeof(name), "method%u", i);
+        rpc.addMethod(name, []() -> JsonVariant {
+            return 1;
+        });
+    }
+}
+
+template<uint8_t N>
+float usPerCall(RpcServer<N>& rpc, const char* request) {
+    size_t len = strlen(request);
+    unsigned long start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        rpc.handleRequest(request, len, out, sizeof(out));
+    }
+    return (float)(micros() - start) / ITERATIONS;
+}
+
+template<uint8_t N>
+void runBenchmark(RpcServer<N>& rpc) {
+    char hit[80];
+    // Last registered method: worst case for a linear scan
+    snprintf(hit, sizeof(hit), "{\"jsonrpc\":\"2.0\",\"method\":\"method%u\",\"id\":1}", N - 1);
+    const char* miss = "{\"jsonrpc\":\"2.0\",\"method\":\"missing\",\"id\":1}";
+    const char* builtin = "{\"jsonrpc\":\"2.0\",\"method\":\"__rpc.version\",\"id\":1}";
+
+    Serial.print(N);
+    Serial.print(" methods: hit ");
+    Serial.print(usPerCall(rpc, hit));
+    Serial.print(" us, miss ");
+    Serial.print(usPerCall(rpc, miss));
+    Serial.print(" us, builtin ");
+    Serial.print(usPerCall(rpc, builtin));
+    Serial.println(" us");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+
+    Serial.println("\n=== RPC Method Lookup Benchmark ===");
+
+    registerMethods(rpc8);
+    registerMethods(rpc32);
+    registerMethods(rpc128);
+
+    runBenchmark(rpc8);
+    runBenchmark(rpc32);
+    runBenchmark(rpc128);
+}
+
+void loop() {
+}
@@ -0,0 +1,90 @@
+/**
+ * Multi-Transport Gateway Example - ESP32
+ * 
+ * One RPC server answering on two UARTs and HTTP at the same time, next
+ * to a 1 kHz control loop. RpcServer::poll() visits every attached
+ * transport without blocking and spends at most RPC_BUDGET_US per loop
+ * iteration on RPC, so the control step stays on schedule.
+ * 
+ * Hardware:
+ * - ESP32
+ * - Serial1 / Serial2 wired to other boards (115200 baud)
+ * 
+ * Usage:
+ * 1. Update WiFi credentials below
+ * 2. Upload sketch
+ * 3. Send JSON-RPC lines on either UART, or HTTP POST to http://YOUR_IP:8080
+ *    {"jsonrpc":"2.0","method":"getLoopStats","id":1}
+ */
+
+#include <WiFi.h>
+#include <RpcServer.h>
+#include <RpcSerialTransport.h>
+#include <RpcHttpServerTransport.h>
+
+// WiFi credentials
+const char* ssid = "YourSSID";
+const char* password = "YourPassword";
+
+const uint32_t CONTROL_PERIOD_US = 1000;  // 1 kHz
+const uint32_t RPC_BUDGET_US = 300;
+
+RpcServer<8> rpc;
+RpcSerialTransport uart1(Serial1);
+RpcSerialTransport uart2(Serial2);
+WiFiServer server(8080);
+RpcHttpServerTransport http(server);
+
+unsigned long nextControl = 0;
+uint32_t overruns = 0;
+uint32_t rpcHandled = 0;
+
+void controlStep() {
+    // Read sensors, run the controller, drive outputs...
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial1.begin(115200);
+    Serial2.begin(115200);
+    
+    WiFi.begin(ssid, password);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(500);
+    }
+    Serial.print("IP Address: ");
+    Serial.println(WiFi.localIP());
+    server.begin();
+    
+    rpc.addMethod("ping", []() -> JsonVariant {
+        return "pong";
+    });
+    
+    rpc.addMethod("getLoopStats", [](JsonObject params, JsonVariant result) {
+        result["overruns"] = overruns;
+        result["rpcHandled"] = rpcHandled;
+        result["uptime"] = millis();
+    });
+    
+    rpc.attach(uart1);
+    rpc.attach(uart2);
+    rpc.attach(http);
+    
+    nextControl = micros();
+}
+
+void loop() {
+    if ((long)(micros() - nextControl) >= 0) {
+        controlStep();
+        nextControl += CONTROL_PERIOD_US;
+        
+        // Fell behind by a whole period: count it and resynchronize
+        if ((long)(micros() - nextControl) >= 0) {
+            overruns++;
+            nextControl = micros() + CONTROL_PERIOD_US;
+        }
+    }
+    
+    // Serve all links within the time left before the next control step
+    rpcHandled += rpc.poll(RPC_BUDGET_US);
+}
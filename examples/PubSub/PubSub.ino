@@ -0,0 +1,54 @@
+/**
+ * Publish/Subscribe Example
+ * 
+ * Instead of polling getSensors, a dashboard subscribes to the "sensors"
+ * topic and the server pushes the readings as JSON-RPC notifications.
+ * publish() only marks the topic changed; the value is read when a
+ * notification is due, so fast updates coalesce into the latest one and
+ * each subscriber gets at most one message per interval.
+ * 
+ * Hardware:
+ * - Any Arduino board
+ * 
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud
+ * 3. Subscribe (named or positional params):
+ *    {"jsonrpc":"2.0","method":"__rpc.subscribe","params":{"topic":"sensors","interval":200},"id":1}
+ *    {"jsonrpc":"2.0","method":"__rpc.unsubscribe","params":["sensors"],"id":2}
+ * 4. Notifications arrive as:
+ *    {"jsonrpc":"2.0","method":"sensors","params":{"a0":512,"uptime":12345}}
+ */
+
+#define RPC_ENABLE_PUBSUB 1
+#include <RpcServer.h>
+#include <RpcSerialTransport.h>
+
+RpcServer<4> rpc;
+RpcSerialTransport transport(Serial);
+
+int lastA0 = -1;
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+    
+    rpc.addTopic("sensors", [](JsonVariant value) {
+        value["a0"] = analogRead(A0);
+        value["uptime"] = millis();
+    });
+    
+    rpc.attach(transport);
+}
+
+void loop() {
+    // Publish on change; the server rate-limits per subscriber
+    int a0 = analogRead(A0);
+    if (abs(a0 - lastA0) > 4) {
+        lastA0 = a0;
+        rpc.publish("sensors");
+    }
+    
+    // Serve requests, then send due notifications
+    rpc.poll(500);
+}
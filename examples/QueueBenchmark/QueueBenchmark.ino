@@ -0,0 +1,91 @@
+/**
+ * RPC Arduino Toolkit - Worker Queue Benchmark
+ *
+ * Measures RpcSpscQueue throughput between the two ESP32 cores: a task
+ * on core 0 produces, loop() on core 1 consumes. Runs once with 4-byte
+ * items and once with full RpcJob slots (filled and read in place), the
+ * way RpcWorker hands requests to loop().
+ *
+ * Hardware:
+ * - ESP32 (dual core)
+ *
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud and read the results
+ *
+ * The host version (test/bench_spsc_queue.cpp) runs it between two
+ * std::threads.
+ */
+
+#define RPC_ENABLE_THREADED 1
+#include <RpcWorker.h>
+
+const uint32_t ITEMS = 200000;
+const uint32_t JOBS = 20000;
+
+RpcSpscQueue<uint32_t, 16> numbers;
+RpcSpscQueue<RpcJob, RPC_WORKER_QUEUE_SIZE> jobs;
+
+void produceNumbers(void*) {
+    for (uint32_t i = 0; i < ITEMS; ) {
+        if (numbers.push(i)) {
+            i++;
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+void produceJobs(void*) {
+    for (uint32_t i = 0; i < JOBS; ) {
+        RpcJob* job = jobs.reserve();
+        if (job) {
+            job->doc.clear();
+            job->doc["method"] = "setSpeed";
+            job->doc["id"] = i;
+            jobs.commit();
+            i++;
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+void report(const char* label, uint32_t count, unsigned long elapsed, bool ok) {
+    Serial.print(label);
+    Serial.print(": ");
+    Serial.print(count * 1000000.0 / elapsed, 0);
+    Serial.print(" items/s");
+    Serial.println(ok ? "" : " (ORDER ERROR)");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+
+    Serial.println("\n=== RPC Worker Queue Benchmark ===");
+
+    bool ok = true;
+    unsigned long start = micros();
+    xTaskCreatePinnedToCore(produceNumbers, "producer", 2048, nullptr, 1, nullptr, 0);
+    for (uint32_t expected = 0; expected < ITEMS; ) {
+        uint32_t value;
+        if (numbers.pop(value)) {
+            ok &= (value == expected++);
+        }
+    }
+    report("uint32  ", ITEMS, micros() - start, ok);
+
+    ok = true;
+    start = micros();
+    xTaskCreatePinnedToCore(produceJobs, "producer", 4096, nullptr, 1, nullptr, 0);
+    for (uint32_t expected = 0; expected < JOBS; ) {
+        RpcJob* job = jobs.front();
+        if (job) {
+            ok &= (job->doc["id"] == expected++);
+            jobs.pop();
+        }
+    }
+    report("RpcJob  ", JOBS, micros() - start, ok);
+}
+
+void loop() {
+}
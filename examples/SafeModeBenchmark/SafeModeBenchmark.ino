@@ -0,0 +1,145 @@
+/**
+ * RPC Arduino Toolkit - Safe Mode Benchmark
+ *
+ * Compares the two ways of producing and reading a safe-mode reply with
+ * a few strings, a timestamp and a 64-bit counter:
+ * - helpers: the handler wraps every value with RpcSafe (one or more
+ *   heap Strings per field) and unwraps params the same way
+ * - codec:   the handler writes plain values and RpcCodec adds/strips
+ *   the S:, D: and n markers while (de)serializing, without allocating
+ *
+ * Reports time per message, heap bytes not returned per message
+ * (ESP32/ESP8266 only) and checks both paths put the same bytes on the wire.
+ *
+ * Hardware:
+ * - ESP32 or ESP8266 (heap figures), any board for timings
+ *
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud and read the results
+ */
+
+#define RPC_ENABLE_SAFE_MODE 1
+#include <RpcServer.h>
+
+const uint16_t ITERATIONS = 500;
+const long long COUNTER = 9007199254740993LL;  // 2^53 + 1: not exact in JavaScript
+
+StaticJsonDocument<RPC_JSON_DOC_SIZE> doc;
+char wire[RPC_MAX_RESPONSE_SIZE];
+char reference[RPC_MAX_RESPONSE_SIZE];
+
+long freeHeap() {
+#if defined(ESP32) || defined(ESP8266)
+    return ESP.getFreeHeap();
+#else
+    return 0;
+#endif
+}
+
+// Helper path: every value wrapped by hand, serialized as plain JSON
+size_t encodeHelpers() {
+    doc.clear();
+    doc["jsonrpc"] = "2.0";
+    JsonObject result = doc.createNestedObject("result");
+    result["device"] = RpcSafe::serializeString("sensor-hub-01");
+    result["status"] = RpcSafe::serializeString("running");
+    result["firmware"] = RpcSafe::serializeString("1.4.2");
+    result["bootedAt"] = RpcSafe::serializeDate(1700000000UL);
+    result["counter"] = RpcSafe::serializeBigInt(COUNTER);
+    result["temperature"] = 21.5;
+    doc["id"] = 1;
+    return serializeJson(doc, wire, sizeof(wire));
+}
+
+// Codec path: plain values, markers added by RpcCodec
+size_t encodeCodec() {
+    doc.clear();
+    doc["jsonrpc"] = "2.0";
+    JsonObject result = doc.createNestedObject("result");
+    result["device"] = "sensor-hub-01";
+    result["status"] = "running";
+    result["firmware"] = "1.4.2";
+    char bootedAt[16];  // Dates have no JSON type: still marked by hand, on the stack
+    snprintf(bootedAt, sizeof(bootedAt), "D:%lu", 1700000000UL);
+    result["bootedAt"] = bootedAt;
+    result["counter"] = COUNTER;
+    result["temperature"] = 21.5;
+    doc["id"] = 1;
+    return RpcCodec::encode(doc, wire, sizeof(wire), RPC_FORMAT_JSON);
+}
+
+// Helper path: parse, then unwrap each field
+long long decodeHelpers(size_t len) {
+    deserializeJson(doc, (const char*)wire, len);  // Copying, like RpcCodec::decode
+    JsonObject result = doc["result"];
+    String device = RpcSafe::deserializeString(result["device"].as<String>());
+    String status = RpcSafe::deserializeString(result["status"].as<String>());
+    String firmware = RpcSafe::deserializeString(result["firmware"].as<String>());
+    unsigned long bootedAt = RpcSafe::deserializeDate(result["bootedAt"].as<String>());
+    return RpcSafe::deserializeBigInt(result["counter"].as<String>()) + bootedAt + device.length() +
+           status.length() + firmware.length();
+}
+
+// Codec path: the document already holds plain values
+long long decodeCodec(size_t len) {
+    RpcCodec::decode(doc, wire, len, RPC_FORMAT_JSON);
+    JsonObject result = doc["result"];
+    const char* device = result["device"];
+    const char* status = result["status"];
+    const char* firmware = result["firmware"];
+    unsigned long bootedAt = result["bootedAt"];
+    return result["counter"].as<long long>() + bootedAt + strlen(device) + strlen(status) + strlen(firmware);
+}
+
+template<typename Encode, typename Decode>
+void runBenchmark(const char* label, Encode encode, Decode decode) {
+    size_t len = encode();  // Warm-up
+
+    long heapBefore = freeHeap();
+    unsigned long start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        len = encode();
+    }
+    float encodeUs = (float)(micros() - start) / ITERATIONS;
+
+    volatile long long sink = 0;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        encode();
+        sink = sink + decode(len);
+    }
+    float decodeUs = (float)(micros() - start) / ITERATIONS - encodeUs;
+    long heapAfter = freeHeap();
+
+    Serial.print(label);
+    Serial.print(": ");
+    Serial.print(len);
+    Serial.print(" bytes, encode ");
+    Serial.print(encodeUs);
+    Serial.print(" us, decode ");
+    Serial.print(decodeUs);
+    Serial.print(" us, heap/msg ");
+    Serial.print((float)(heapBefore - heapAfter) / (2 * ITERATIONS));
+    Serial.println(" B");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+
+    Serial.println("\n=== RPC Safe Mode Benchmark ===");
+
+    size_t len = encodeHelpers();
+    memcpy(reference, wire, len + 1);
+    encodeCodec();
+    Serial.print("Same wire bytes: ");
+    Serial.println(strcmp(reference, wire) == 0 ? "yes" : "NO");
+    Serial.println(wire);
+
+    runBenchmark("helpers", encodeHelpers, decodeHelpers);
+    runBenchmark("codec  ", encodeCodec, decodeCodec);
+}
+
+void loop() {
+}
@@ -0,0 +1,65 @@
+/**
+ * Threaded RPC Server Example - ESP32
+ * 
+ * JSON parsing and dispatch run on a worker task pinned to core 0, so
+ * loop() on core 1 only runs the motor control step. Methods that touch
+ * the controller state are marked RPC_RUN_ON_LOOP: the worker hands them
+ * to loop() through a lock-free queue and writes their replies back.
+ * 
+ * Hardware:
+ * - ESP32
+ * 
+ * Usage:
+ * 1. Upload this sketch
+ * 2. Open Serial Monitor at 115200 baud
+ * 3. Send JSON-RPC commands:
+ *    {"jsonrpc":"2.0","method":"setSpeed","params":{"rpm":1200},"id":1}
+ *    {"jsonrpc":"2.0","method":"getInfo","id":2}
+ */
+
+#define RPC_ENABLE_THREADED 1
+#include <RpcServer.h>
+#include <RpcSerialTransport.h>
+#include <RpcWorker.h>
+
+RpcServer<8> rpc;
+RpcSerialTransport transport(Serial);
+RpcWorker<8> worker(rpc);
+
+// Controller state: only touched from loop()
+float targetRpm = 0;
+float currentRpm = 0;
+
+void motorControl() {
+    currentRpm += (targetRpm - currentRpm) * 0.01;
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+    
+    // Runs on the worker: no shared state
+    rpc.addMethod("getInfo", [](JsonObject params, JsonVariant result) {
+        result["uptime"] = millis();
+        result["freeHeap"] = ESP.getFreeHeap();
+        result["core"] = xPortGetCoreID();
+    });
+    
+    // Runs in loop(): reads and writes the controller state
+    rpc.addMethod("setSpeed", [](JsonObject params, JsonVariant result) {
+        targetRpm = params["rpm"] | 0.0;
+        result["target"] = targetRpm;
+        result["current"] = currentRpm;
+        result["core"] = xPortGetCoreID();
+    });
+    rpc.setMethodContext("setSpeed", RPC_RUN_ON_LOOP);
+    
+    worker.attach(transport);
+    worker.begin();
+}
+
+void loop() {
+    motorControl();
+    worker.runLoopHandlers();
+    delay(1);
+}
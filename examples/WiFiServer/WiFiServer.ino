@@ -12,11 +12,14 @@
  * 2. Upload sketch
  * 3. Open Serial Monitor to see IP address
  * 4. Send HTTP POST requests to http://YOUR_IP:8080
+ * 
+ * Connections are kept alive (HTTP/1.1), so a dashboard can issue many
+ * calls over one TCP connection instead of reconnecting for each one.
  */
 
 #include <WiFi.h>
 #include <RpcServer.h>
-#include <RpcWiFiTransport.h>
+#include <RpcHttpServerTransport.h>
 
 // WiFi credentials
 const char* ssid = "YourSSID";
@@ -25,6 +28,7 @@ const char* password = "YourPassword";
 // Create RPC server
 RpcServer<8> rpc;
 WiFiServer server(8080);
+RpcHttpServerTransport transport(server);
 
 // Sensor simulation
 float temperature = 25.0;
@@ -67,22 +71,16 @@ void setup() {
 }
 
 void loop() {
-    // Check for client connections
-    WiFiClient client = server.available();
+    // Serve the next complete request from any connection (non-blocking)
+    String response = rpc.handleRequest(transport);
+    if (!response.isEmpty()) {
+        transport.write(response);
+    }
     
-    if (client) {
-        Serial.println("Client connected");
-        
-        // Create transport
-        RpcWiFiTransport transport(client);
-        
-        // Handle request
-        String response = rpc.handleRequest(transport);
-        
-        client.stop();
-        Serial.println("Client disconnected\n");
-        
-        // Simulate sensor changes
+    // Simulate sensor changes
+    static unsigned long lastUpdate = 0;
+    if (millis() - lastUpdate >= 1000) {
+        lastUpdate = millis();
         temperature += random(-10, 10) / 10.0;
         humidity += random(-5, 5) / 10.0;
     }
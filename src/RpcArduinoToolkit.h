@@ -9,15 +9,21 @@
 
 // Core files
 #include "RpcConfig.h"
+#include "RpcCodec.h"
+#include "RpcMemoryPool.h"
 #include "RpcTypes.h"
 #include "RpcTransport.h"
 #include "RpcSerialTransport.h"
+#include "RpcCobsTransport.h"
+#include "RpcLoopbackTransport.h"
 #include "RpcServer.h"
 #include "RpcClient.h"
+#include "RpcWorker.h"
 
 // Platform-specific transports
 #if RPC_HAS_WIFI
   #include "RpcWiFiTransport.h"
+  #include "RpcHttpServerTransport.h"
 #endif
 
 #if RPC_HAS_BLE
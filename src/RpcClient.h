@@ -5,29 +5,333 @@
 #ifndef RPC_CLIENT_H
 #define RPC_CLIENT_H
 
+#include <type_traits>
 #include <ArduinoJson.h>
 #include "RpcConfig.h"
 #include "RpcTypes.h"
 #include "RpcTransport.h"
 
+// Completion callback for asynchronous calls (fired from RpcClient::poll)
+typedef std::function<void(RpcResponse&)> RpcResponseCallback;
+
+// Writes a request's params straight into the request document: set
+// members (params["pin"] = 2) or add items (params.add(2)); leaving
+// params untouched sends no params
+typedef std::function<void(JsonVariant params)> RpcParamsWriter;
+
+#if RPC_ENABLE_NOTIFICATIONS
+// Callback for notifications pushed by the server (fired from RpcClient::poll)
+typedef std::function<void(JsonVariantConst params)> RpcNotificationCallback;
+#endif
+
+// Selects the positional call()/notify() overloads: any argument list except
+// a single string (params as a JSON string), a single JsonObject/JsonArray
+// (sent as the params themselves) or a single params writer
+template<typename First, typename... Rest>
+struct RpcPositionalArgs {
+    typedef typename std::decay<First>::type Arg;
+    static const bool value = sizeof...(Rest) > 0 ||
+        !(std::is_same<Arg, const char*>::value || std::is_same<Arg, char*>::value ||
+          std::is_same<Arg, String>::value || std::is_same<Arg, JsonObject>::value ||
+          std::is_same<Arg, JsonArray>::value || std::is_convertible<Arg, RpcParamsWriter>::value);
+};
+
 class RpcClient {
 private:
+    struct PendingCall {
+        uint32_t id;
+        unsigned long sentAt;
+        RpcResponseCallback callback;
+        bool active;
+        bool queued;  // Request still waiting in the batch frame
+    };
+    
     RpcTransport& transport;
     unsigned long timeout;
     uint32_t requestId;
+    PendingCall pending[RPC_MAX_PENDING_CALLS];
+#if RPC_ENABLE_NOTIFICATIONS
+    struct Listener {
+        char method[RPC_MAX_METHOD_NAME];
+        uint32_t hash;
+        RpcNotificationCallback callback;
+        bool active;
+    };
+    
+    Listener listeners[RPC_MAX_LISTENERS];
+    
+    Listener* findListener(const char* method) {
+        uint32_t hash = RpcHash::compute(method);
+        for (Listener& l : listeners) {
+            if (l.active && l.hash == hash && strcmp(l.method, method) == 0) {
+                return &l;
+            }
+        }
+        return nullptr;
+    }
+#endif
+    
+#if RPC_ENABLE_BATCH
+    // Requests queued by setBatching(), already encoded and framed: "[a,b"
+    // for JSON, or a 3-byte array header (count patched on flush) followed
+    // by the requests for MessagePack
+    String batchFrame;
+    uint8_t batchItems;
+    unsigned long batchStartedAt;
+    unsigned long batchDelay;
+    bool batching;
+    
+    // Append a request to the batch frame, flushing first when it would
+    // exceed RPC_MAX_BATCH_ITEMS or not fit a receive buffer of
+    // RPC_MAX_REQUEST_SIZE bytes (which holds the terminator too)
+    void enqueue(const String& request) {
+        bool json = transport.getFormat() == RPC_FORMAT_JSON;
+        
+        // Closing bracket and separator, or nothing (header already counted)
+        size_t framed = batchFrame.length() + request.length() + (json ? 2 : 0);
+        if (batchItems >= RPC_MAX_BATCH_ITEMS || (batchItems > 0 && framed >= RPC_MAX_REQUEST_SIZE)) {
+            flush();
+        }
+        
+        if (batchItems == 0) {
+            batchFrame = "";
+            batchFrame.reserve(RPC_MAX_REQUEST_SIZE);
+            if (json) {
+                batchFrame += '[';
+            } else {
+                // array 16: always 3 bytes, so the count can be patched in place
+                const uint8_t header[] = {0xDC, 0, 0};
+                RpcCodec::appendBytes(batchFrame, header, sizeof(header));
+            }
+            batchStartedAt = millis();
+        } else if (json) {
+            batchFrame += ',';
+        }
+        
+        if (json) {
+            batchFrame += request;
+        } else {
+            RpcCodec::appendBytes(batchFrame, (const uint8_t*)request.c_str(), request.length());
+        }
+        batchItems++;
+    }
+#endif
+    
+    // Write a request, or queue it while batching
+    bool send(const String& request) {
+#if RPC_ENABLE_BATCH
+        if (batching) {
+            enqueue(request);
+            return true;
+        }
+#endif
+        return transport.write(request);
+    }
+    
+#if RPC_ENABLE_METHOD_IDS
+    // Method name hash -> numeric ID, loaded by fetchMethodIds()
+    struct MethodId {
+        uint32_t hash;
+        uint32_t id;
+    };
+    
+    static const uint32_t AMBIGUOUS_ID = 0xFFFFFFFF;  // Names sharing a hash: call by name
+    
+    MethodId methodIds[RPC_MAX_METHOD_IDS];
+    uint8_t idCount;
+    uint32_t byIdRequest;  // Request id of the last call sent by method ID
+    
+    MethodId* findMethodId(const char* method) {
+        uint32_t hash = RpcHash::compute(method);
+        for (uint8_t i = 0; i < idCount; i++) {
+            if (methodIds[i].hash == hash) {
+                return &methodIds[i];
+            }
+        }
+        return nullptr;
+    }
+#endif
+    
+    // Next request id; 0 is reserved as the "no handle" value
+    uint32_t nextId() {
+        if (requestId == 0) {
+            requestId = 1;
+        }
+        return requestId;
+    }
+    
+    // Read one response frame from the transport, false if none.
+    // Notifications pushed by the server are dispatched on the way.
+    bool readResponse(RpcResponse& resp) {
+        while (transport.available()) {
+            String responseJson = transport.read();
+            if (responseJson.isEmpty()) {
+                return false;
+            }
+            
+            RPC_LOG_F("Client response: %s", responseJson.c_str());
+            resp.parse(responseJson, transport.getFormat());
+            if (resp.isBatch()) {
+                completeBatch(resp);
+                continue;
+            }
+            if (!resp.isNotification()) {
+                return true;
+            }
+            dispatchNotification(resp);
+        }
+        return false;
+    }
+    
+    // Hand a server notification to its listener, if any
+    void dispatchNotification(RpcResponse& notification) {
+#if RPC_ENABLE_NOTIFICATIONS
+        Listener* listener = findListener(notification.method());
+        if (listener) {
+            // Copy first: the callback may remove its own listener
+            RpcNotificationCallback callback = listener->callback;
+            callback(notification.params());
+            return;
+        }
+#endif
+        (void)notification;
+        RPC_LOG_F("Dropping notification %s", notification.method());
+    }
+    
+    // Hand a response to the pending call with the same id, if any
+    bool completePending(RpcResponse& resp) {
+        uint32_t id = resp.id().as<uint32_t>();
+        if (id == 0) {
+            return false;
+        }
+        staleMethodId(resp);
+        
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            if (pending[i].active && pending[i].id == id) {
+                finishPending(pending[i], resp);
+                return true;
+            }
+        }
+        
+        RPC_LOG_F("Dropping response for unknown id %lu", (unsigned long)id);
+        return false;
+    }
+    
+    // Reserve a pending slot for the next request id. Taken before
+    // sending: a batch flushed on the way may fire callbacks that start
+    // calls of their own.
+    PendingCall* takeSlot(const RpcResponseCallback& callback) {
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            PendingCall& slot = pending[i];
+            if (!slot.active) {
+                slot.id = nextId();
+                slot.sentAt = millis();
+                slot.callback = callback;
+                slot.active = true;
+                slot.queued = false;
+                return &slot;
+            }
+        }
+        
+        RPC_LOG("Too many pending calls!");
+        return nullptr;
+    }
+    
+    // Keep the slot if its request went out (or was queued), free it otherwise
+    uint32_t settleSlot(PendingCall* slot, bool sent) {
+        if (!sent) {
+            slot->active = false;
+            slot->callback = nullptr;
+            return 0;
+        }
+        slot->queued = isBatching();
+        return slot->id;
+    }
+    
+    // Route each response of a batch reply to its pending call
+    void completeBatch(RpcResponse& batch) {
+        for (size_t i = 0; i < batch.batchSize(); i++) {
+            batch.selectItem(i);
+            if (batch.isNotification()) {
+                dispatchNotification(batch);
+            } else {
+                completePending(batch);
+            }
+        }
+    }
+    
+    // Free the slot before firing, so the callback may issue new calls
+    void finishPending(PendingCall& call, RpcResponse& resp) {
+        RpcResponseCallback callback;
+        callback.swap(call.callback);
+        call.active = false;
+        
+        if (callback) {
+            callback(resp);
+        }
+    }
+    
+    // Write "method": the cached ID for calls when there is one, else the
+    // name. Notifications always carry the name: a stale ID would be
+    // dropped by the server without any error coming back.
+    void setMethod(JsonDocument& doc, const char* method, bool isNotification) {
+#if RPC_ENABLE_METHOD_IDS
+        const MethodId* entry = isNotification ? nullptr : findMethodId(method);
+        if (entry && entry->id != AMBIGUOUS_ID) {
+            doc["method"] = entry->id;
+            byIdRequest = nextId();
+            return;
+        }
+#else
+        (void)isNotification;
+#endif
+        doc["method"] = method;
+    }
+    
+    // True if resp rejects the last call sent by ID as stale (the server
+    // removed a method or restarted); the ID table is dropped
+    bool staleMethodId(const RpcResponse& resp) {
+#if RPC_ENABLE_METHOD_IDS
+        if (byIdRequest != 0 && resp.errorCode() == RPC_ERROR_METHOD_NOT_FOUND &&
+            resp.id().as<uint32_t>() == byIdRequest) {
+            RPC_LOG("Method IDs are stale");
+            byIdRequest = 0;
+            clearMethodIds();
+            return true;
+        }
+#else
+        (void)resp;
+#endif
+        return false;
+    }
+    
+    // For call(): true if resp rejects a stale method ID, after reloading
+    // the ID table, so the request is sent again
+    bool reloadStaleMethodIds(const RpcResponse& resp) {
+#if RPC_ENABLE_METHOD_IDS
+        if (!staleMethodId(resp)) {
+            return false;
+        }
+        fetchMethodIds();  // On failure the resend goes by name
+        return true;
+#else
+        (void)resp;
+        return false;
+#endif
+    }
     
     // Build request JSON
     String buildRequest(const char* method, const String& params, bool isNotification = false) {
-        StaticJsonDocument<RPC_JSON_DOC_SIZE> doc;
+        RpcDocument<RPC_JSON_DOC_SIZE> doc;
         
         doc["jsonrpc"] = "2.0";
-        doc["method"] = method;
+        setMethod(doc, method, isNotification);
         
         // Parse params if provided
         if (!params.isEmpty()) {
             if (params[0] == '{' || params[0] == '[') {
                 // JSON params
-                StaticJsonDocument<512> paramsDoc;
+                RpcDocument<512> paramsDoc;
                 deserializeJson(paramsDoc, params);
                 doc["params"] = paramsDoc;
             } else {
@@ -36,19 +340,151 @@ private:
             }
         }
         
-        // Add ID unless notification
+        return finishRequest(doc, isNotification);
+    }
+    
+    // Build a request whose params are the positional array [args...],
+    // written straight into the document
+    template<typename... Args>
+    String buildPositional(const char* method, bool isNotification, const Args&... args) {
+        RpcDocument<RPC_JSON_DOC_SIZE> doc;
+        
+        doc["jsonrpc"] = "2.0";
+        setMethod(doc, method, isNotification);
+        
+        JsonArray params = doc.createNestedArray("params");
+        int expand[] = {0, (params.add(args), 0)...};
+        (void)expand;
+        
+        return finishRequest(doc, isNotification);
+    }
+    
+    // Add the id (unless notification)
+    void setId(JsonDocument& doc, bool isNotification) {
         if (!isNotification) {
-            doc["id"] = requestId++;
+            doc["id"] = nextId();
+            requestId++;
         }
+    }
+    
+    // Add the id (unless notification) and encode
+    String finishRequest(JsonDocument& doc, bool isNotification) {
+        setId(doc, isNotification);
         
         String output;
-        serializeJson(doc, output);
+        RpcCodec::encode(doc, output, transport.getFormat());
         return output;
     }
     
+    // Build a request whose params are written by writeParams directly
+    // into the document, and serialize it straight to the transport (or
+    // into the batch frame when queue is set and batching is on). The
+    // document lives only in this frame, not while a call waits.
+    bool writeRequest(const char* method, const RpcParamsWriter& writeParams, bool isNotification, bool queue) {
+        RpcDocument<RPC_JSON_DOC_SIZE> doc;
+        
+        doc["jsonrpc"] = "2.0";
+        setMethod(doc, method, isNotification);
+        
+        if (writeParams) {
+            JsonVariant params = doc["params"].to<JsonVariant>();
+            writeParams(params);
+            if (params.isNull()) {
+                doc.remove("params");
+            }
+        }
+        
+        setId(doc, isNotification);
+        
+        if (queue && isBatching()) {
+            String request;
+            RpcCodec::encode(doc, request, transport.getFormat());
+            return send(request);
+        }
+        return transport.writeDocument(doc);
+    }
+    
+    // Send a request and wait for the response carrying its id; responses
+    // to asynchronous calls arriving meanwhile are routed to their callbacks.
+    // write() builds the request and writes it (true on success). A request
+    // rejected for a stale method ID is sent again.
+    template<typename Write>
+    RpcResponse exchange(Write write) {
+        RpcResponse resp = exchangeOnce(write);
+        if (reloadStaleMethodIds(resp)) {
+            resp = exchangeOnce(write);
+        }
+        return resp;
+    }
+    
+    template<typename Write>
+    RpcResponse exchangeOnce(Write& write) {
+#if RPC_ENABLE_BATCH
+        // Queued requests go first, keeping the order calls were made in.
+        // Before the id is taken: a callback fired by flush() may start
+        // calls of its own.
+        flush();
+#endif
+        
+        uint32_t id = nextId();
+        return awaitResponse(id, write());
+    }
+    
+    bool writeCall(const String& request) {
+        RPC_LOG_F("Client call: %s", request.c_str());
+        return transport.write(request);
+    }
+    
+    // Wait for the response to the request just written (sent: the write
+    // succeeded)
+    RpcResponse awaitResponse(uint32_t id, bool sent) {
+        if (!sent) {
+            RpcResponse resp;
+            resp.setError(RPC_ERROR_SERVER, "Failed to send request", nullptr);
+            return resp;
+        }
+        
+        RpcResponse resp;
+        unsigned long start = millis();
+        while (millis() - start < timeout) {
+            if (readResponse(resp)) {
+                JsonVariantConst respId = resp.id();
+                if (respId.isNull() || respId.as<uint32_t>() == id) {
+                    return resp;
+                }
+                completePending(resp);
+            }
+            yield();
+        }
+        
+        // Timeout
+        resp.setError(RPC_ERROR_SERVER, "Request timeout", nullptr);
+        return resp;
+    }
+    
 public:
     explicit RpcClient(RpcTransport& t) 
-        : transport(t), timeout(RPC_DEFAULT_TIMEOUT), requestId(1) {}
+        : transport(t), timeout(RPC_DEFAULT_TIMEOUT), requestId(1) {
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            pending[i].active = false;
+            pending[i].queued = false;
+        }
+#if RPC_ENABLE_BATCH
+        batchItems = 0;
+        batchStartedAt = 0;
+        batchDelay = 0;
+        batching = false;
+#endif
+#if RPC_ENABLE_METHOD_IDS
+        idCount = 0;
+        byIdRequest = 0;
+#endif
+#if RPC_ENABLE_NOTIFICATIONS
+        for (Listener& l : listeners) {
+            l.active = false;
+        }
+#endif
+    }
     
     /**
      * Call remote method
@@ -57,46 +493,384 @@ public:
      * @return RpcResponse object
      */
     RpcResponse call(const char* method, const String& params = "") {
+        return exchange([&]() {
+            return writeCall(buildRequest(method, params));
+        });
+    }
+    
+    /**
+     * Call remote method with positional params
+     * The arguments are sent as the params array, in order:
+     *   client.call("add", 5, 3);  // {"method":"add","params":[5,3],...}
+     * A single string argument is still taken as a JSON params string.
+     * @param method Method name
+     * @param args Values ArduinoJson can store (numbers, bool, strings,
+     *        JsonVariant/JsonObject/JsonArray)
+     * @return RpcResponse object
+     */
+    template<typename First, typename... Rest>
+    typename std::enable_if<RpcPositionalArgs<First, Rest...>::value, RpcResponse>::type
+    call(const char* method, const First& first, const Rest&... rest) {
+        return exchange([&]() {
+            return writeCall(buildPositional(method, false, first, rest...));
+        });
+    }
+    
+    /**
+     * Start a non-blocking call
+     * The callback fires from poll() with the response, or with a timeout
+     * error after getTimeout() ms. While batching, the request is queued
+     * (the timeout runs from then) and its callback gets an error if the
+     * batch cannot be sent.
+     * @param method Method name
+     * @param params Parameters as JSON string
+     * @param callback Completion callback
+     * @return Call handle (the request id), 0 if the pending table is full
+     *         or the request could not be sent
+     */
+    uint32_t callAsync(const char* method, const String& params, RpcResponseCallback callback) {
+        PendingCall* slot = takeSlot(callback);
+        if (!slot) {
+            return 0;
+        }
+        
         String request = buildRequest(method, params);
+        RPC_LOG_F("Client callAsync: %s", request.c_str());
+        return settleSlot(slot, send(request));
+    }
+    
+    /**
+     * Start a non-blocking call whose params are written by writeParams
+     * straight into the request (see call())
+     */
+    uint32_t callAsync(const char* method, RpcParamsWriter writeParams, RpcResponseCallback callback) {
+        PendingCall* slot = takeSlot(callback);
+        if (!slot) {
+            return 0;
+        }
         
-        RPC_LOG_F("Client call: %s", request.c_str());
+        RPC_LOG_F("Client callAsync: %s", method);
+        return settleSlot(slot, writeRequest(method, writeParams, false, true));
+    }
+    
+    /**
+     * Start a non-blocking call without parameters
+     */
+    uint32_t callAsync(const char* method, RpcResponseCallback callback) {
+        return callAsync(method, "", callback);
+    }
+    
+    /**
+     * Drive asynchronous calls - call from loop()
+     * Reads every available response, matches it to its pending call by id
+     * (responses may arrive in any order) and expires timed-out calls.
+     * Server notifications are dispatched to their listeners. While
+     * batching, the queued requests are sent once the batch delay has run.
+     */
+    void poll() {
+#if RPC_ENABLE_BATCH
+        if (batchItems > 0 && millis() - batchStartedAt >= batchDelay) {
+            flush();
+        }
+#endif
         
-        // Send request
-        if (!transport.write(request)) {
-            RpcResponse resp;
-            resp.setError(RPC_ERROR_SERVER, "Failed to send request", nullptr);
-            return resp;
+        if (pendingCount() == 0 && listenerCount() == 0) {
+            return;
         }
         
-        // Wait for response
-        unsigned long start = millis();
-        while (millis() - start < timeout) {
-            if (transport.available()) {
-                String responseJson = transport.read();
-                if (!responseJson.isEmpty()) {
-                    RPC_LOG_F("Client response: %s", responseJson.c_str());
-                    
-                    RpcResponse resp;
-                    resp.parse(responseJson);
-                    return resp;
+        RpcResponse resp;
+        while (readResponse(resp)) {
+            completePending(resp);
+        }
+        
+        unsigned long now = millis();
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            if (pending[i].active && now - pending[i].sentAt >= timeout) {
+                resp.setError(RPC_ERROR_SERVER, "Request timeout", pending[i].id);
+                finishPending(pending[i], resp);
+            }
+        }
+    }
+    
+    /**
+     * Cancel a pending asynchronous call (its callback will not fire)
+     * @return true if the call was still pending
+     */
+    bool cancel(uint32_t handle) {
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            if (pending[i].active && pending[i].id == handle) {
+                pending[i].active = false;
+                pending[i].callback = nullptr;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Number of asynchronous calls in flight
+     */
+    uint8_t pendingCount() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            if (pending[i].active) {
+                count++;
+            }
+        }
+        return count;
+    }
+    
+#if RPC_ENABLE_BATCH
+    /**
+     * Queue callAsync() and notify() requests and send them as one
+     * JSON-RPC batch frame (server built with RPC_ENABLE_BATCH)
+     * The frame goes out from poll() delayMs after its first request (0:
+     * at the next poll(), so everything queued during one loop() pass is
+     * coalesced), when it reaches RPC_MAX_BATCH_ITEMS requests or
+     * RPC_MAX_REQUEST_SIZE bytes, before a blocking call(), or on flush().
+     * Responses are matched to their callbacks by id, like callAsync().
+     * Disabling sends whatever is queued.
+     */
+    void setBatching(bool enabled, unsigned long delayMs = 0) {
+        if (!enabled) {
+            flush();
+        }
+        batching = enabled;
+        batchDelay = delayMs;
+    }
+    
+    /**
+     * Send the queued requests now
+     * @return false if the frame could not be written (the queued calls
+     *         complete with an error)
+     */
+    bool flush() {
+        if (batchItems == 0) {
+            return true;
+        }
+        
+        if (transport.getFormat() == RPC_FORMAT_JSON) {
+            batchFrame += ']';
+        } else {
+            batchFrame.setCharAt(1, (char)(batchItems >> 8));
+            batchFrame.setCharAt(2, (char)(batchItems & 0xFF));
+        }
+        
+        RPC_LOG_F("Client batch (%u): %s", (unsigned)batchItems, batchFrame.c_str());
+        bool sent = transport.write(batchFrame);
+        batchItems = 0;
+        batchFrame = "";
+        
+        // Clear every flag before firing: a callback may queue new calls
+        bool inFrame[RPC_MAX_PENDING_CALLS];
+        for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+            inFrame[i] = pending[i].active && pending[i].queued;
+            pending[i].queued = false;
+        }
+        
+        if (!sent) {
+            RpcResponse resp;
+            for (uint8_t i = 0; i < RPC_MAX_PENDING_CALLS; i++) {
+                if (inFrame[i] && pending[i].active) {
+                    resp.setError(RPC_ERROR_SERVER, "Failed to send request", pending[i].id);
+                    finishPending(pending[i], resp);
                 }
             }
-            delay(10);
+        }
+        return sent;
+    }
+    
+    /**
+     * Number of requests waiting in the batch frame
+     */
+    uint8_t queuedCount() const {
+        return batchItems;
+    }
+#endif
+    
+    /**
+     * True while setBatching() is queueing requests
+     */
+    bool isBatching() const {
+#if RPC_ENABLE_BATCH
+        return batching;
+#else
+        return false;
+#endif
+    }
+    
+    /**
+     * Number of registered notification listeners
+     */
+    uint8_t listenerCount() const {
+        uint8_t count = 0;
+#if RPC_ENABLE_NOTIFICATIONS
+        for (const Listener& l : listeners) {
+            if (l.active) {
+                count++;
+            }
+        }
+#endif
+        return count;
+    }
+    
+#if RPC_ENABLE_NOTIFICATIONS
+    /**
+     * Call a function for every notification the server sends with this
+     * method name (fired from poll() and while call() waits)
+     * Registering the same name again replaces the callback.
+     * @return false if RPC_MAX_LISTENERS is reached or the name is too long
+     */
+    bool onNotification(const char* method, RpcNotificationCallback callback) {
+        Listener* listener = findListener(method);
+        if (!listener) {
+            if (strlen(method) >= RPC_MAX_METHOD_NAME) {
+                return false;
+            }
+            for (uint8_t i = 0; !listener && i < RPC_MAX_LISTENERS; i++) {
+                if (!listeners[i].active) {
+                    listener = &listeners[i];
+                }
+            }
+            if (!listener) {
+                RPC_LOG("Too many notification listeners!");
+                return false;
+            }
+            strncpy(listener->method, method, RPC_MAX_METHOD_NAME - 1);
+            listener->method[RPC_MAX_METHOD_NAME - 1] = '\0';
+            listener->hash = RpcHash::compute(listener->method);
+            listener->active = true;
         }
         
-        // Timeout
-        RpcResponse resp;
-        resp.setError(RPC_ERROR_SERVER, "Request timeout", nullptr);
-        return resp;
+        listener->callback = callback;
+        return true;
+    }
+    
+    /**
+     * Stop listening for a notification
+     */
+    bool removeNotification(const char* method) {
+        Listener* listener = findListener(method);
+        if (!listener) {
+            return false;
+        }
+        listener->active = false;
+        listener->callback = nullptr;
+        return true;
+    }
+    
+    /**
+     * Subscribe to a server topic (server built with RPC_ENABLE_PUBSUB)
+     * The server pushes the topic's latest value at most every intervalMs;
+     * keep calling poll() to receive them.
+     * @return true if the server accepted the subscription
+     */
+    bool subscribe(const char* topic, uint32_t intervalMs, RpcNotificationCallback callback) {
+        if (!onNotification(topic, callback)) {
+            return false;
+        }
+        
+        if (!call("__rpc.subscribe", topic, intervalMs).result<bool>()) {
+            removeNotification(topic);
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * Cancel a subscription made with subscribe()
+     */
+    bool unsubscribe(const char* topic) {
+        removeNotification(topic);
+        return exchange([&]() {
+            return writeCall(buildPositional("__rpc.unsubscribe", false, topic));
+        }).result<bool>();
+    }
+#endif
+    
+#if RPC_ENABLE_METHOD_IDS
+    /**
+     * Load numeric method IDs from the server (built with
+     * RPC_ENABLE_METHOD_IDS) via __rpc.methodIds
+     * Calls to the listed methods then send the ID instead of the name,
+     * and the server indexes its table directly. When the server rejects
+     * an ID as stale, call() reloads the table and resends; an async
+     * call's callback receives the error and later calls go by name until
+     * fetchMethodIds() is called again.
+     * @return true if IDs were loaded (at most RPC_MAX_METHOD_IDS)
+     */
+    bool fetchMethodIds() {
+        clearMethodIds();
+        RpcResponse resp = call("__rpc.methodIds");
+        if (!resp.isSuccess()) {
+            return false;
+        }
+        
+        for (JsonPairConst entry : resp.result()["methods"].as<JsonObjectConst>()) {
+            const char* name = entry.key().c_str();
+            MethodId* known = findMethodId(name);
+            if (known) {
+                known->id = AMBIGUOUS_ID;
+                continue;
+            }
+            if (idCount >= RPC_MAX_METHOD_IDS) {
+                RPC_LOG("Too many method IDs, calling the rest by name");
+                break;
+            }
+            methodIds[idCount].hash = RpcHash::compute(name);
+            methodIds[idCount].id = entry.value().as<uint32_t>();
+            idCount++;
+        }
+        return idCount > 0;
+    }
+    
+    /**
+     * Go back to calling every method by name
+     */
+    void clearMethodIds() {
+        idCount = 0;
+    }
+    
+    /**
+     * Number of methods called by ID
+     */
+    uint8_t methodIdCount() const {
+        return idCount;
+    }
+#endif
+    
+    /**
+     * Call a method whose params are written by writeParams straight into
+     * the request document, which is then serialized to the transport:
+     *   client.call("setLED", [](JsonVariant params) {
+     *       params["pin"] = 2;
+     *       params["state"] = true;
+     *   });
+     * No params String is built and parsed back into a second document.
+     * @param method Method name
+     * @param writeParams Params writer (may run twice if a stale method
+     *        ID forces a resend)
+     * @return RpcResponse object
+     */
+    RpcResponse call(const char* method, RpcParamsWriter writeParams) {
+        return exchange([&]() {
+            RPC_LOG_F("Client call: %s", method);
+            return writeRequest(method, writeParams, false, false);
+        });
     }
     
     /**
-     * Call method with JsonObject params
+     * Call method with JsonObject params (copied into the request)
      */
     RpcResponse call(const char* method, JsonObject params) {
-        String paramsStr;
-        serializeJson(params, paramsStr);
-        return call(method, paramsStr);
+        return call(method, [&params](JsonVariant out) { out.set(params); });
+    }
+    
+    /**
+     * Call method with JsonArray (positional) params
+     */
+    RpcResponse call(const char* method, JsonArray params) {
+        return call(method, [&params](JsonVariant out) { out.set(params); });
     }
     
     /**
@@ -105,16 +879,40 @@ public:
     void notify(const char* method, const String& params = "") {
         String request = buildRequest(method, params, true);
         RPC_LOG_F("Client notify: %s", request.c_str());
-        transport.write(request);
+        send(request);
+    }
+    
+    /**
+     * Send notification with params written by writeParams (see call())
+     */
+    void notify(const char* method, RpcParamsWriter writeParams) {
+        RPC_LOG_F("Client notify: %s", method);
+        writeRequest(method, writeParams, true, true);
     }
     
     /**
      * Send notification with JsonObject params
      */
     void notify(const char* method, JsonObject params) {
-        String paramsStr;
-        serializeJson(params, paramsStr);
-        notify(method, paramsStr);
+        notify(method, [&params](JsonVariant out) { out.set(params); });
+    }
+    
+    /**
+     * Send notification with JsonArray (positional) params
+     */
+    void notify(const char* method, JsonArray params) {
+        notify(method, [&params](JsonVariant out) { out.set(params); });
+    }
+    
+    /**
+     * Send notification with positional params (see call())
+     */
+    template<typename First, typename... Rest>
+    typename std::enable_if<RpcPositionalArgs<First, Rest...>::value>::type
+    notify(const char* method, const First& first, const Rest&... rest) {
+        String request = buildPositional(method, true, first, rest...);
+        RPC_LOG_F("Client notify: %s", request.c_str());
+        send(request);
     }
     
     /**
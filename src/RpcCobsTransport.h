@@ -0,0 +1,510 @@
+/**
+ * RPC Arduino Toolkit - COBS Serial Transport
+ * 
+ * Reliable binary framing for noisy links (RS-485, long UART runs)
+ * 
+ * Every frame is [type][seq][payload...][CRC-16 hi][CRC-16 lo], COBS
+ * encoded and terminated by a 0x00 byte, so a receiver always resyncs on
+ * the next delimiter. A frame failing its CRC is NAKed at once with the
+ * sequence number the receiver is waiting for; a gap in the sequence
+ * NAKs the missing numbers. The sender keeps unacknowledged frames in a
+ * fixed window of RPC_COBS_WINDOW slots and retransmits only the frame
+ * asked for, or any frame not ACKed within RPC_COBS_RETRY_MS. A
+ * corrupted request is thus recovered in a few milliseconds instead of
+ * failing the call after the client timeout. Duplicates (lost ACKs) are
+ * ACKed again but not delivered twice.
+ * 
+ * Frames are carried as-is, so both RPC_FORMAT_JSON and
+ * RPC_FORMAT_MSGPACK work. Both ends must use this transport.
+ * 
+ * Usage:
+ *   RpcCobsTransport link(Serial1);
+ *   rpc.attach(link);
+ */
+
+#ifndef RPC_COBS_TRANSPORT_H
+#define RPC_COBS_TRANSPORT_H
+
+#include "RpcTransport.h"
+
+class RpcCobsTransport : public RpcTransport {
+private:
+    static const uint8_t TYPE_DATA = 0x01;
+    static const uint8_t TYPE_ACK = 0x02;
+    static const uint8_t TYPE_NAK = 0x03;
+    static const uint8_t FLAG_RESET = 0x80;  // Sender restarted: seq counts from here
+    
+    static const size_t OVERHEAD = 4;  // type + seq + CRC-16
+    static const size_t MAX_FRAME = RPC_MAX_REQUEST_SIZE + OVERHEAD;
+    static const size_t MAX_ENCODED = MAX_FRAME + MAX_FRAME / 254 + 1;
+    static const uint8_t RX_WINDOW = 32;  // Out-of-order frames tracked by rxSeen
+    
+    // Sent frame kept (already CRC'd) until the peer ACKs it
+    struct Slot {
+        uint8_t data[MAX_FRAME];
+        size_t len;
+        unsigned long sentAt;
+        uint8_t retries;
+        bool nakked;       // A NAK already triggered a resend of this copy
+        bool used;
+    };
+    
+    Stream& serial;
+    
+    // Receive side
+    uint8_t rx[MAX_ENCODED];
+    size_t rxLen;          // Encoded bytes of the current frame, then payload length
+    bool frameReady;       // rx holds a delivered payload at rx + 2
+    bool discarding;       // Skipping an oversize frame up to its delimiter
+    uint8_t rxNext;        // Lowest sequence number not yet received
+    uint32_t rxSeen;       // Bit i: rxNext + 1 + i already received
+    bool rxFromReset;      // Synced on a FLAG_RESET frame, peer not past it yet
+    
+    // Send side
+    Slot window[RPC_COBS_WINDOW];
+    uint8_t txSeq;
+    bool synced;           // Peer has ACKed a frame: stop sending FLAG_RESET
+    
+    uint32_t crcFailures;
+    uint32_t resent;
+    uint32_t lost;
+    uint32_t dropped;
+    uint32_t reported;
+    
+    static uint16_t crc16(const uint8_t* data, size_t len) {
+        uint16_t crc = 0xFFFF;  // CRC-16/CCITT-FALSE
+        while (len--) {
+            crc ^= (uint16_t)(*data++) << 8;
+            for (uint8_t i = 0; i < 8; i++) {
+                crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+            }
+        }
+        return crc;
+    }
+    
+    // Decode a COBS block in place (output never overtakes input)
+    // @return Decoded length, 0 if malformed
+    static size_t cobsDecode(uint8_t* buf, size_t len) {
+        size_t in = 0;
+        size_t out = 0;
+        while (in < len) {
+            uint8_t code = buf[in++];
+            if (code == 0 || in + code - 1 > len) {
+                return 0;
+            }
+            for (uint8_t i = 1; i < code; i++) {
+                buf[out++] = buf[in++];
+            }
+            if (code < 0xFF && in < len) {
+                buf[out++] = 0;
+            }
+        }
+        return out;
+    }
+    
+    // COBS-encode data straight into the stream, then the delimiter
+    void sendEncoded(const uint8_t* data, size_t len) {
+        size_t start = 0;
+        while (true) {
+            size_t end = start;
+            while (end < len && data[end] != 0 && end - start < 254) {
+                end++;
+            }
+            serial.write((uint8_t)(end - start + 1));
+            serial.write(data + start, end - start);
+            if (end >= len) {
+                break;
+            }
+            // A full block (code 0xFF) implies no zero: the next byte
+            // starts the next block even when it is a zero itself
+            start = end - start < 254 && data[end] == 0 ? end + 1 : end;
+        }
+        serial.write((uint8_t)0);
+        serial.flush();
+    }
+    
+    // Append the CRC to a frame whose first len bytes are filled
+    static size_t seal(uint8_t* frame, size_t len) {
+        uint16_t crc = crc16(frame, len);
+        frame[len] = (uint8_t)(crc >> 8);
+        frame[len + 1] = (uint8_t)(crc & 0xFF);
+        return len + 2;
+    }
+    
+    void sendControl(uint8_t type, uint8_t seq) {
+        uint8_t frame[OVERHEAD] = {type, seq};
+        sendEncoded(frame, seal(frame, 2));
+    }
+    
+    // Slot for a new frame; evicts the oldest unacknowledged one if full
+    Slot& claimSlot() {
+        // A frame stuck while later ones got through would fall out of the
+        // receiver's window, which then skips it anyway
+        for (Slot& slot : window) {
+            if (slot.used && (uint8_t)(txSeq - slot.data[1]) >= RX_WINDOW) {
+                RPC_LOG_F("COBS frame %u too old, dropping", slot.data[1]);
+                slot.used = false;
+                lost++;
+            }
+        }
+        
+        Slot* oldest = &window[0];
+        for (Slot& slot : window) {
+            if (!slot.used) {
+                return slot;
+            }
+            if ((long)(slot.sentAt - oldest->sentAt) < 0) {
+                oldest = &slot;
+            }
+        }
+        RPC_LOG("COBS window full, dropping oldest frame");
+        lost++;
+        return *oldest;
+    }
+    
+    // Seal and send a frame whose payload (len bytes) is at slot.data + 2
+    bool sendData(Slot& slot, size_t len) {
+        slot.data[0] = synced ? TYPE_DATA : (TYPE_DATA | FLAG_RESET);
+        slot.data[1] = txSeq++;
+        slot.len = seal(slot.data, len + 2);
+        slot.sentAt = millis();
+        slot.retries = 0;
+        slot.nakked = false;
+        slot.used = true;
+        sendEncoded(slot.data, slot.len);
+        return true;
+    }
+    
+    void retransmit(Slot& slot) {
+        if (slot.retries >= RPC_COBS_MAX_RETRIES) {
+            RPC_LOG_F("COBS frame %u lost", slot.data[1]);
+            slot.used = false;
+            lost++;
+            return;
+        }
+        slot.retries++;
+        slot.nakked = false;
+        slot.sentAt = millis();
+        resent++;
+        sendEncoded(slot.data, slot.len);
+    }
+    
+    Slot* findSlot(uint8_t seq) {
+        for (Slot& slot : window) {
+            if (slot.used && slot.data[1] == seq) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+    
+    // The peer follows our sequence: reseal pending frames without the
+    // reset flag, so a late resend cannot pass for a new restart
+    void markSynced() {
+        synced = true;
+        for (Slot& slot : window) {
+            if (slot.used) {
+                slot.data[0] &= ~FLAG_RESET;
+                slot.len = seal(slot.data, slot.len - 2);
+            }
+        }
+    }
+    
+    // Sequence bookkeeping for a valid DATA frame
+    // @return true if the payload is new and must be delivered
+    bool acceptData(uint8_t seq, bool reset) {
+        uint8_t d = (uint8_t)(seq - rxNext);
+        bool ahead = d < 128;  // Otherwise behind rxNext: already delivered
+        
+        // The peer restarted: follow its new sequence (a late copy of a
+        // reset frame already seen is within the window and handled as usual)
+        if (reset && !rxFromReset && d > RX_WINDOW) {
+            rxNext = seq;
+            rxSeen = 0;
+            d = 0;
+            ahead = true;
+        }
+        rxFromReset = reset;
+        sendControl(TYPE_ACK, seq);
+        
+        if (!ahead) {
+            return false;  // Only the ACK was lost
+        }
+        
+        if (d == 0) {
+            rxNext++;
+            while (rxSeen & 1) {
+                rxSeen >>= 1;
+                rxNext++;
+            }
+            rxSeen >>= 1;
+            return true;
+        }
+        
+        if (d <= RX_WINDOW) {
+            uint32_t bit = (uint32_t)1 << (d - 1);
+            if (rxSeen & bit) {
+                return false;
+            }
+            
+            // NAK the gap this frame opens past the furthest one seen so far
+            // (earlier gaps were NAKed when they appeared)
+            uint8_t furthest = 0;
+            while (furthest < RX_WINDOW && (rxSeen >> furthest)) {
+                furthest++;
+            }
+            for (uint8_t i = furthest ? furthest + 1 : 0; i < d; i++) {
+                sendControl(TYPE_NAK, (uint8_t)(rxNext + i));
+            }
+            rxSeen |= bit;
+            return true;
+        }
+        
+        // Past the window: the sender gave up on the missing frames
+        // (it never keeps a frame RX_WINDOW sequence numbers old), skip them
+        rxNext = (uint8_t)(seq + 1);
+        rxSeen = 0;
+        return true;
+    }
+    
+    // Handle one decoded frame held in rx
+    // @return true if a payload was delivered
+    bool handleFrame(size_t len) {
+        if (len < OVERHEAD || crc16(rx, len - 2) != (uint16_t)((rx[len - 2] << 8) | rx[len - 1])) {
+            RPC_LOG("COBS frame failed CRC, sending NAK");
+            crcFailures++;
+            sendControl(TYPE_NAK, rxNext);
+            return false;
+        }
+        
+        uint8_t type = rx[0] & ~FLAG_RESET;
+        uint8_t seq = rx[1];
+        
+        if (type == TYPE_ACK) {
+            Slot* slot = findSlot(seq);
+            if (slot) {
+                slot->used = false;
+                if (!synced) {
+                    markSynced();
+                }
+            }
+            return false;
+        }
+        
+        if (type == TYPE_NAK) {
+            // One resend per copy: later NAKs for the same gap are dropped
+            // and the retry timer covers a lost resend
+            Slot* slot = findSlot(seq);
+            if (slot && !slot->nakked) {
+                retransmit(*slot);
+                slot->nakked = true;
+            }
+            return false;
+        }
+        
+        if (type != TYPE_DATA || !acceptData(seq, rx[0] & FLAG_RESET)) {
+            return false;
+        }
+        
+        rxLen = len - OVERHEAD;
+        rx[2 + rxLen] = '\0';  // Over the CRC, already checked
+        return true;
+    }
+    
+    // Retransmit frames whose ACK is overdue
+    void checkTimers() {
+        unsigned long now = millis();
+        for (Slot& slot : window) {
+            if (slot.used && now - slot.sentAt >= RPC_COBS_RETRY_MS) {
+                retransmit(slot);
+            }
+        }
+    }
+    
+    /**
+     * Consume available bytes, handling control frames, until a payload
+     * is delivered (never blocks)
+     */
+    bool pollFrame() {
+        checkTimers();
+        if (frameReady) {
+            return true;
+        }
+        
+        while (serial.available() > 0) {
+            int c = serial.read();
+            if (c < 0) {
+                break;
+            }
+            
+            if (c == 0) {
+                size_t len = discarding ? 0 : cobsDecode(rx, rxLen);
+                bool wasDiscarding = discarding;
+                discarding = false;
+                rxLen = 0;
+                
+                if (wasDiscarding) {
+                    continue;
+                }
+                if (handleFrame(len)) {
+                    frameReady = true;
+                    return true;
+                }
+                continue;
+            }
+            
+            if (discarding) {
+                continue;
+            }
+            
+            if (rxLen >= sizeof(rx)) {
+                RPC_LOG("COBS frame too large, discarding");
+                discarding = true;
+                dropped++;
+                continue;
+            }
+            
+            rx[rxLen++] = (uint8_t)c;
+        }
+        
+        return false;
+    }
+    
+    void consumeFrame() {
+        frameReady = false;
+        rxLen = 0;
+    }
+    
+public:
+    explicit RpcCobsTransport(Stream& s)
+        : serial(s), rxLen(0), frameReady(false), discarding(false), rxNext(0), rxSeen(0), rxFromReset(false),
+          txSeq(0), synced(false), crcFailures(0), resent(0), lost(0), dropped(0), reported(0) {
+        for (Slot& slot : window) {
+            slot.used = false;
+        }
+        setTimeout(RPC_SERIAL_TIMEOUT);
+    }
+    
+    String read() override {
+        if (!pollFrame()) {
+            return "";
+        }
+        
+        String result;
+        result.reserve(rxLen);
+        RpcCodec::appendBytes(result, rx + 2, rxLen);
+        consumeFrame();
+        return result;
+    }
+    
+    size_t readFrame(char* buf, size_t cap) override {
+        if (cap == 0 || !pollFrame()) {
+            return 0;
+        }
+        
+        // Too large for the caller: dropped like an oversize frame
+        if (rxLen >= cap) {
+            RPC_LOG("COBS frame too large for buffer, discarding");
+            consumeFrame();
+            dropped++;
+            return 0;
+        }
+        
+        size_t len = rxLen;
+        memcpy(buf, rx + 2, len);
+        buf[len] = '\0';
+        consumeFrame();
+        return len;
+    }
+    
+    bool writeFrame(const char* data, size_t len) override {
+        if (len > RPC_MAX_REQUEST_SIZE) {
+            RPC_LOG("COBS payload too large");
+            return false;
+        }
+        
+        Slot& slot = claimSlot();
+        memcpy(slot.data + 2, data, len);
+        return sendData(slot, len);
+    }
+    
+    bool writeDocument(JsonVariantConst doc) override {
+        if (RpcCodec::measure(doc, format) > RPC_MAX_REQUEST_SIZE) {
+            RPC_LOG("COBS payload too large");
+            return false;
+        }
+        
+        // Encoded straight into the retransmit slot (the terminator lands
+        // where the CRC goes)
+        Slot& slot = claimSlot();
+        size_t len = RpcCodec::encode(doc, (char*)slot.data + 2, RPC_MAX_REQUEST_SIZE + 1, format);
+        return sendData(slot, len);
+    }
+    
+    bool write(const String& data) override {
+        return writeFrame(data.c_str(), data.length());
+    }
+    
+    /**
+     * Also drives retransmissions: call it (or poll the server/client) often
+     */
+    bool available() override {
+        return pollFrame();
+    }
+    
+    bool hasFrameBuffer() const override {
+        return true;
+    }
+    
+    char* peekFrame(size_t& len) override {
+        len = pollFrame() ? rxLen : 0;
+        return len ? (char*)rx + 2 : nullptr;
+    }
+    
+    void releaseFrame() override {
+        consumeFrame();
+    }
+    
+    uint32_t takeDroppedFrames() override {
+        uint32_t count = dropped - reported;
+        reported = dropped;
+        return count;
+    }
+    
+    /**
+     * Frames received with a bad CRC (each one was NAKed)
+     */
+    uint32_t crcErrors() const {
+        return crcFailures;
+    }
+    
+    /**
+     * Frames sent again after a NAK or a missing ACK
+     */
+    uint32_t retransmits() const {
+        return resent;
+    }
+    
+    /**
+     * Frames given up on (RPC_COBS_MAX_RETRIES exceeded, window full, or
+     * overtaken by 32 later frames)
+     */
+    uint32_t lostFrames() const {
+        return lost;
+    }
+    
+    /**
+     * Frames sent but not yet acknowledged
+     */
+    uint8_t unacked() const {
+        uint8_t count = 0;
+        for (const Slot& slot : window) {
+            if (slot.used) {
+                count++;
+            }
+        }
+        return count;
+    }
+};
+
+#endif // RPC_COBS_TRANSPORT_H
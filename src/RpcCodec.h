@@ -0,0 +1,579 @@
+/**
+ * RPC Arduino Toolkit - Wire Codec
+ * 
+ * Encodes and decodes JSON-RPC messages as JSON text or MessagePack
+ */
+
+#ifndef RPC_CODEC_H
+#define RPC_CODEC_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "RpcConfig.h"
+
+// ============================================================================
+// Wire Formats
+// ============================================================================
+
+enum RpcFormat : uint8_t {
+    RPC_FORMAT_JSON = 0,      // Textual JSON (default, newline-safe)
+    RPC_FORMAT_MSGPACK = 1    // Binary MessagePack (needs RPC_ENABLE_MSGPACK)
+};
+
+#if RPC_ENABLE_SAFE_MODE
+// ============================================================================
+// Safe Mode Codec (if RPC_ENABLE_SAFE_MODE)
+// ============================================================================
+
+/**
+ * Applies the safe-mode conventions to the params and result of every
+ * JSON message, so handlers only see plain values:
+ * - strings travel as "S:text"
+ * - integers beyond +/-(2^53 - 1), not exact in JavaScript, travel as "123n"
+ * - "D:" dates arrive as the timestamp (digits) or as the text after "D:"
+ * 
+ * Decoding rewrites the document in place: prefixes are skipped rather
+ * than copied (linked strings stay linked, so in-situ parsing is kept)
+ * and "123n" is parsed as a 64-bit integer. Encoding adds the markers
+ * while writing. Neither direction allocates from the heap.
+ * 
+ * Strings already in safe form (S:, D:, 123n) are sent unchanged, so
+ * values built with the RpcSafe helpers still go out as before.
+ */
+class RpcSafeCodec {
+private:
+    static const long long MAX_SAFE_INTEGER = 9007199254740991LL;  // 2^53 - 1
+    
+    // Counts bytes (measure)
+    class CountingPrint : public Print {
+    public:
+        size_t write(uint8_t) override {
+            return 1;
+        }
+        
+        size_t write(const uint8_t*, size_t size) override {
+            return size;
+        }
+    };
+    
+    // Fills a caller buffer like serializeJson(src, buf, cap): stops at
+    // cap bytes, NUL-terminates when there is room
+    class BufferPrint : public Print {
+    public:
+        BufferPrint(char* buffer, size_t capacity) : buf(buffer), cap(capacity), len(0) {}
+        
+        size_t write(uint8_t c) override {
+            if (len >= cap) {
+                return 0;
+            }
+            buf[len++] = (char)c;
+            return 1;
+        }
+        
+        size_t finish() {
+            if (len < cap) {
+                buf[len] = '\0';
+            }
+            return len;
+        }
+        
+    private:
+        char* buf;
+        size_t cap;
+        size_t len;
+    };
+    
+    // Appends to a String (reserved up front by the caller)
+    class StringPrint : public Print {
+    public:
+        explicit StringPrint(String& s) : str(s) {}
+        
+        size_t write(uint8_t c) override {
+            str += (char)c;
+            return 1;
+        }
+        
+    private:
+        String& str;
+    };
+    
+    static bool isPrefixed(const char* s, size_t len) {
+        return len >= 2 && s[1] == ':' && (s[0] == 'S' || s[0] == 'D');
+    }
+    
+    static bool isBigInt(const char* s, size_t len) {
+        long long value;
+        return len >= 2 && s[len - 1] == 'n' && parseInt64(s, len - 1, value);
+    }
+    
+    static void setInteger(JsonVariant v, long long value) {
+#if ARDUINOJSON_USE_LONG_LONG
+        v.set(value);
+#else
+        // No 64-bit storage: keep the text when the value does not fit
+        if (value >= LONG_MIN && value <= LONG_MAX) {
+            v.set((long)value);
+        }
+#endif
+    }
+    
+    // Strip the safe-mode markers from one value, recursively
+    static void decodeValue(JsonVariant v) {
+        if (v.is<JsonObject>()) {
+            for (JsonPair member : v.as<JsonObject>()) {
+                decodeValue(member.value());
+            }
+            return;
+        }
+        
+        if (v.is<JsonArray>()) {
+            for (JsonVariant item : v.as<JsonArray>()) {
+                decodeValue(item);
+            }
+            return;
+        }
+        
+        if (!v.is<const char*>()) {
+            return;
+        }
+        
+        JsonString str = v.as<JsonString>();
+        const char* s = str.c_str();
+        size_t len = str.size();
+        long long value = 0;
+        
+        if (isPrefixed(s, len)) {
+            if (s[0] == 'D' && parseInt64(s + 2, len - 2, value)) {
+                setInteger(v, value);
+            } else {
+                // Point past the prefix; an owned string is copied into the
+                // document pool, since a link into the pool would dangle
+                // once the document is copied
+                v.set(JsonString(s + 2, len - 2, str.isLinked() ? JsonString::Linked : JsonString::Copied));
+            }
+        } else if (isBigInt(s, len)) {
+            parseInt64(s, len - 1, value);
+            setInteger(v, value);
+        }
+    }
+    
+    static size_t writeString(JsonString str, Print& out, bool prefix) {
+        size_t n = out.write('"');
+        if (prefix) {
+            n += out.write((const uint8_t*)"S:", 2);
+        }
+        
+        const char* s = str.c_str();
+        for (size_t i = 0; i < str.size(); i++) {
+            char escape = 0;
+            switch (s[i]) {
+                case '"': escape = '"'; break;
+                case '\\': escape = '\\'; break;
+                case '\b': escape = 'b'; break;
+                case '\f': escape = 'f'; break;
+                case '\n': escape = 'n'; break;
+                case '\r': escape = 'r'; break;
+                case '\t': escape = 't'; break;
+            }
+            if (escape) {
+                n += out.write('\\');
+                n += out.write((uint8_t)escape);
+            } else if ((uint8_t)s[i] < 0x20) {
+                // Other control characters are not allowed raw in JSON
+                char hex[7];
+                snprintf(hex, sizeof(hex), "\\u%04x", (unsigned)(uint8_t)s[i]);
+                n += out.write((const uint8_t*)hex, 6);
+            } else {
+                n += out.write((uint8_t)s[i]);
+            }
+        }
+        
+        return n + out.write('"');
+    }
+    
+    // Write one value with the safe-mode markers added
+    static size_t writeValue(JsonVariantConst v, Print& out) {
+        if (v.is<JsonObjectConst>()) {
+            size_t n = out.write('{');
+            bool first = true;
+            for (JsonPairConst member : v.as<JsonObjectConst>()) {
+                if (!first) {
+                    n += out.write(',');
+                }
+                first = false;
+                n += writeString(member.key(), out, false);
+                n += out.write(':');
+                n += writeValue(member.value(), out);
+            }
+            return n + out.write('}');
+        }
+        
+        if (v.is<JsonArrayConst>()) {
+            size_t n = out.write('[');
+            bool first = true;
+            for (JsonVariantConst item : v.as<JsonArrayConst>()) {
+                if (!first) {
+                    n += out.write(',');
+                }
+                first = false;
+                n += writeValue(item, out);
+            }
+            return n + out.write(']');
+        }
+        
+        if (v.is<const char*>()) {
+            JsonString str = v.as<JsonString>();
+            return writeString(str, out, !isPrefixed(str.c_str(), str.size()) && !isBigInt(str.c_str(), str.size()));
+        }
+        
+#if ARDUINOJSON_USE_LONG_LONG
+        // Integers JavaScript cannot hold exactly become "123n"
+        char digits[24];
+        if (v.is<long long>()) {
+            long long value = v.as<long long>();
+            if (value > MAX_SAFE_INTEGER || value < -MAX_SAFE_INTEGER) {
+                snprintf(digits, sizeof(digits), "\"%lldn\"", value);
+                return out.write((const uint8_t*)digits, strlen(digits));
+            }
+        } else if (v.is<unsigned long long>()) {
+            snprintf(digits, sizeof(digits), "\"%llun\"", v.as<unsigned long long>());
+            return out.write((const uint8_t*)digits, strlen(digits));
+        }
+#endif
+        
+        return serializeJson(v, out);
+    }
+    
+    // A message is an object with "jsonrpc", or a batch of them; anything
+    // else (e.g. a result encoded on its own for the cache) is a payload
+    static bool isMessage(JsonVariantConst v) {
+        if (v.is<JsonArrayConst>()) {
+            return v.size() > 0 && isMessage(v[0]);
+        }
+        return v.is<JsonObjectConst>() && !v["jsonrpc"].isNull();
+    }
+    
+    static bool isPayloadKey(const char* key) {
+        return strcmp(key, "params") == 0 || strcmp(key, "result") == 0;
+    }
+    
+    static size_t writeMessage(JsonVariantConst msg, Print& out) {
+        if (msg.is<JsonArrayConst>()) {
+            size_t n = out.write('[');
+            bool first = true;
+            for (JsonVariantConst item : msg.as<JsonArrayConst>()) {
+                if (!first) {
+                    n += out.write(',');
+                }
+                first = false;
+                n += writeMessage(item, out);
+            }
+            return n + out.write(']');
+        }
+        
+        // Envelope members (jsonrpc, method, id, error) are written as-is
+        size_t n = out.write('{');
+        bool first = true;
+        for (JsonPairConst member : msg.as<JsonObjectConst>()) {
+            if (!first) {
+                n += out.write(',');
+            }
+            first = false;
+            n += writeString(member.key(), out, false);
+            n += out.write(':');
+            n += isPayloadKey(member.key().c_str()) ? writeValue(member.value(), out)
+                                                    : serializeJson(member.value(), out);
+        }
+        return n + out.write('}');
+    }
+    
+public:
+    /**
+     * Parse a base-10 integer of exactly len characters into 64 bits
+     * @return false on any non-digit or overflow
+     */
+    static bool parseInt64(const char* s, size_t len, long long& out) {
+        bool negative = len > 0 && s[0] == '-';
+        size_t i = negative ? 1 : 0;
+        if (i == len) {
+            return false;
+        }
+        
+        const unsigned long long limit = negative ? 9223372036854775808ULL : 9223372036854775807ULL;
+        unsigned long long value = 0;
+        for (; i < len; i++) {
+            if (s[i] < '0' || s[i] > '9') {
+                return false;
+            }
+            unsigned digit = s[i] - '0';
+            if (value > (limit - digit) / 10) {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        
+        out = negative ? (long long)(0 - value) : (long long)value;
+        return true;
+    }
+    
+    /**
+     * Strip the markers from the params/result of a decoded message (or
+     * batch), in place
+     */
+    static void decode(JsonVariant doc) {
+        if (doc.is<JsonArray>()) {
+            for (JsonVariant item : doc.as<JsonArray>()) {
+                decode(item);
+            }
+            return;
+        }
+        
+        for (JsonPair member : doc.as<JsonObject>()) {
+            if (isPayloadKey(member.key().c_str())) {
+                decodeValue(member.value());
+            }
+        }
+    }
+    
+    /**
+     * Write src as JSON with the markers added
+     * @return Bytes written
+     */
+    static size_t write(JsonVariantConst src, Print& out) {
+        return isMessage(src) ? writeMessage(src, out) : writeValue(src, out);
+    }
+    
+    static size_t write(JsonVariantConst src, char* out, size_t cap) {
+        BufferPrint print(out, cap);
+        write(src, print);
+        return print.finish();
+    }
+    
+    static size_t write(JsonVariantConst src, String& out) {
+        out.reserve(out.length() + measure(src));
+        StringPrint print(out);
+        return write(src, print);
+    }
+    
+    /**
+     * Size of the JSON write(src) produces
+     */
+    static size_t measure(JsonVariantConst src) {
+        CountingPrint print;
+        return write(src, print);
+    }
+};
+#endif
+
+// ============================================================================
+// RPC Codec
+// ============================================================================
+
+class RpcCodec {
+private:
+    // ArduinoJson's String writer stops at NUL bytes, which MessagePack
+    // output contains: append byte by byte instead
+    class StringWriter {
+    public:
+        explicit StringWriter(String& s) : str(s) {}
+        
+        size_t write(uint8_t c) {
+            str += (char)c;
+            return 1;
+        }
+        
+        size_t write(const uint8_t* data, size_t len) {
+            appendBytes(str, data, len);
+            return len;
+        }
+    
+    private:
+        String& str;
+    };
+    
+    // JSON input passes through the safe-mode decoder (no-op without it)
+    static DeserializationError unwrap(JsonDocument& doc, DeserializationError error) {
+#if RPC_ENABLE_SAFE_MODE
+        if (!error) {
+            RpcSafeCodec::decode(doc.as<JsonVariant>());
+        }
+#else
+        (void)doc;
+#endif
+        return error;
+    }
+    
+public:
+    /**
+     * Append raw (possibly binary) bytes to a String
+     */
+    static void appendBytes(String& str, const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            str += (char)data[i];
+        }
+    }
+    
+    /**
+     * Decode a message into doc
+     */
+    static DeserializationError decode(JsonDocument& doc, const char* in, size_t len, RpcFormat format) {
+#if RPC_ENABLE_MSGPACK
+        if (format == RPC_FORMAT_MSGPACK) {
+            return deserializeMsgPack(doc, in, len);
+        }
+#else
+        if (format == RPC_FORMAT_MSGPACK) {
+            return DeserializationError::InvalidInput;
+        }
+#endif
+        return unwrap(doc, deserializeJson(doc, in, len));
+    }
+    
+    /**
+     * Decode a message in place (zero-copy): strings in doc point into in,
+     * which is modified and must outlive doc
+     */
+    static DeserializationError decodeInPlace(JsonDocument& doc, char* in, size_t len, RpcFormat format) {
+#if RPC_ENABLE_MSGPACK
+        if (format == RPC_FORMAT_MSGPACK) {
+            return deserializeMsgPack(doc, in, len);
+        }
+#else
+        if (format == RPC_FORMAT_MSGPACK) {
+            return DeserializationError::InvalidInput;
+        }
+#endif
+        return unwrap(doc, deserializeJson(doc, in, len));
+    }
+    
+    /**
+     * Encode src into a caller-supplied buffer
+     * @return Bytes written, 0 on failure
+     */
+    static size_t encode(JsonVariantConst src, char* out, size_t cap, RpcFormat format) {
+#if RPC_ENABLE_MSGPACK
+        if (format == RPC_FORMAT_MSGPACK) {
+            return serializeMsgPack(src, out, cap);
+        }
+#else
+        if (format == RPC_FORMAT_MSGPACK) {
+            return 0;
+        }
+#endif
+#if RPC_ENABLE_SAFE_MODE
+        return RpcSafeCodec::write(src, out, cap);
+#else
+        return serializeJson(src, out, cap);
+#endif
+    }
+    
+    /**
+     * Encode src into a String (binary-safe)
+     * @return Bytes written
+     */
+    static size_t encode(JsonVariantConst src, String& out, RpcFormat format) {
+#if RPC_ENABLE_MSGPACK
+        if (format == RPC_FORMAT_MSGPACK) {
+            out.reserve(measureMsgPack(src));
+            StringWriter writer(out);
+            return serializeMsgPack(src, writer);
+        }
+#else
+        if (format == RPC_FORMAT_MSGPACK) {
+            return 0;
+        }
+#endif
+#if RPC_ENABLE_SAFE_MODE
+        return RpcSafeCodec::write(src, out);
+#else
+        return serializeJson(src, out);
+#endif
+    }
+    
+    /**
+     * Encode src straight into a Print/Stream (no intermediate buffer)
+     * @return Bytes written
+     */
+    static size_t encode(JsonVariantConst src, Print& out, RpcFormat format) {
+#if RPC_ENABLE_MSGPACK
+        if (format == RPC_FORMAT_MSGPACK) {
+            return serializeMsgPack(src, out);
+        }
+#else
+        if (format == RPC_FORMAT_MSGPACK) {
+            return 0;
+        }
+#endif
+#if RPC_ENABLE_SAFE_MODE
+        return RpcSafeCodec::write(src, out);
+#else
+        return serializeJson(src, out);
+#endif
+    }
+    
+    /**
+     * Size of the encoded message in bytes
+     */
+    static size_t measure(JsonVariantConst src, RpcFormat format) {
+#if RPC_ENABLE_MSGPACK
+        if (format == RPC_FORMAT_MSGPACK) {
+            return measureMsgPack(src);
+        }
+#else
+        (void)format;
+#endif
+#if RPC_ENABLE_SAFE_MODE
+        return RpcSafeCodec::measure(src);
+#else
+        return measureJson(src);
+#endif
+    }
+};
+
+// ============================================================================
+// Buffered Print
+// ============================================================================
+
+/**
+ * Small write-combining buffer in front of a Print
+ * ArduinoJson writes mostly one byte at a time; on network clients each
+ * write() may become a packet, so bytes are grouped into SIZE-byte chunks.
+ */
+template<size_t SIZE = 64>
+class RpcBufferedPrint : public Print {
+private:
+    Print& target;
+    uint8_t buffer[SIZE];
+    size_t len;
+    
+public:
+    explicit RpcBufferedPrint(Print& p) : target(p), len(0) {}
+    
+    ~RpcBufferedPrint() {
+        flush();
+    }
+    
+    size_t write(uint8_t c) override {
+        buffer[len++] = c;
+        if (len == SIZE) {
+            flush();
+        }
+        return 1;
+    }
+    
+    size_t write(const uint8_t* data, size_t size) override {
+        for (size_t i = 0; i < size; i++) {
+            write(data[i]);
+        }
+        return size;
+    }
+    
+    void flush() override {
+        if (len > 0) {
+            target.write(buffer, len);
+            len = 0;
+        }
+    }
+};
+
+#endif // RPC_CODEC_H
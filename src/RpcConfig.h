@@ -37,6 +37,47 @@
   #define RPC_MAX_RESPONSE_SIZE RPC_MAX_REQUEST_SIZE
 #endif
 
+// Maximum number of asynchronous client calls in flight
+#ifndef RPC_MAX_PENDING_CALLS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_PENDING_CALLS 8
+  #else
+    #define RPC_MAX_PENDING_CALLS 2
+  #endif
+#endif
+
+// Requests per batch frame a client queues before flushing (RPC_ENABLE_BATCH)
+#ifndef RPC_MAX_BATCH_ITEMS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_BATCH_ITEMS 16
+  #else
+    #define RPC_MAX_BATCH_ITEMS 8
+  #endif
+#endif
+
+// Method IDs a client caches from __rpc.methodIds (RPC_ENABLE_METHOD_IDS)
+#ifndef RPC_MAX_METHOD_IDS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_METHOD_IDS 16
+  #else
+    #define RPC_MAX_METHOD_IDS 4
+  #endif
+#endif
+
+// Maximum transports attached to one server (served by RpcServer::poll)
+#ifndef RPC_MAX_TRANSPORTS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_TRANSPORTS 4
+  #else
+    #define RPC_MAX_TRANSPORTS 2
+  #endif
+#endif
+
+// Maximum requests handled by one RpcServer::poll() call
+#ifndef RPC_POLL_MAX_REQUESTS
+  #define RPC_POLL_MAX_REQUESTS 4
+#endif
+
 // Maximum method name length
 #ifndef RPC_MAX_METHOD_NAME
   #define RPC_MAX_METHOD_NAME 32
@@ -51,7 +92,12 @@
   #define RPC_ENABLE_SAFE_MODE 0  // Disabled by default to save memory
 #endif
 
-// Enable batch requests
+// Enable MessagePack wire format (RPC_FORMAT_MSGPACK) alongside JSON
+#ifndef RPC_ENABLE_MSGPACK
+  #define RPC_ENABLE_MSGPACK 0  // Disabled by default to save flash
+#endif
+
+// Enable batch requests (server) and request batching (RpcClient::setBatching)
 #ifndef RPC_ENABLE_BATCH
   #define RPC_ENABLE_BATCH 1
 #endif
@@ -66,11 +112,52 @@
   #define RPC_ENABLE_NOTIFICATIONS 1
 #endif
 
+// Enable per-method metrics and the __rpc.stats introspection method
+#ifndef RPC_ENABLE_METRICS
+  #define RPC_ENABLE_METRICS 0  // Disabled by default (zero overhead when off)
+#endif
+
+// Enable the response cache for idempotent methods (see setMethodCache)
+#ifndef RPC_ENABLE_CACHE
+  #define RPC_ENABLE_CACHE 0  // Disabled by default (uses RPC_CACHE_ENTRIES slots)
+#endif
+
+// Carve every per-request JSON document from one RpcMemoryPool arena
+// instead of the stack (see RpcMemoryPool::setDefault)
+#ifndef RPC_ENABLE_MEMORY_POOL
+  #define RPC_ENABLE_MEMORY_POOL 0  // Disabled by default
+#endif
+
+// Enable server-push subscriptions (__rpc.subscribe, RpcServer::publish)
+#ifndef RPC_ENABLE_PUBSUB
+  #define RPC_ENABLE_PUBSUB 0  // Disabled by default
+#endif
+
+// Accept numeric method IDs (slot + table generation, listed by
+// __rpc.methodIds) in place of method names; see RpcClient::fetchMethodIds
+#ifndef RPC_ENABLE_METHOD_IDS
+  #define RPC_ENABLE_METHOD_IDS 0  // Disabled by default
+#endif
+
+// Parse requests in place in the transport's receive buffer (see
+// RpcTransport::peekFrame): strings are referenced, not copied
+#ifndef RPC_ENABLE_IN_SITU
+  #define RPC_ENABLE_IN_SITU 0  // Disabled by default
+#endif
+
 // Enable schema support (adds description and exposeSchema per method)
 #ifndef RPC_ENABLE_SCHEMA_SUPPORT
   #define RPC_ENABLE_SCHEMA_SUPPORT 1  // Enabled by default (minimal overhead)
 #endif
 
+// Copy method names and descriptions given as RAM strings into the method
+// table (RPC_MAX_METHOD_NAME + RPC_MAX_DESCRIPTION bytes per slot). Set to 0
+// to store pointers only: names must then outlive the server (literals).
+// Flash strings (F()/FPSTR()) are always stored by pointer.
+#ifndef RPC_COPY_METHOD_NAMES
+  #define RPC_COPY_METHOD_NAMES 1
+#endif
+
 // Maximum description length (if schema support enabled)
 #ifndef RPC_MAX_DESCRIPTION
   #define RPC_MAX_DESCRIPTION 64
@@ -95,14 +182,137 @@
   #define RPC_WIFI_TIMEOUT 10000
 #endif
 
+// HTTP keep-alive: idle time before a persistent connection is closed
+#ifndef RPC_HTTP_KEEPALIVE_TIMEOUT
+  #define RPC_HTTP_KEEPALIVE_TIMEOUT 15000
+#endif
+
+// ============================================================================
+// HTTP Server Transport
+// ============================================================================
+
+// Maximum concurrent HTTP client connections (each holds a request buffer)
+#ifndef RPC_HTTP_MAX_CONNECTIONS
+  #if defined(ESP32)
+    #define RPC_HTTP_MAX_CONNECTIONS 4
+  #else
+    #define RPC_HTTP_MAX_CONNECTIONS 2
+  #endif
+#endif
+
+// ============================================================================
+// COBS Serial Transport
+// ============================================================================
+
+// Sent frames kept for retransmission until ACKed (each holds one
+// RPC_MAX_REQUEST_SIZE frame)
+#ifndef RPC_COBS_WINDOW
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_COBS_WINDOW 4
+  #else
+    #define RPC_COBS_WINDOW 1
+  #endif
+#endif
+
+// Retransmit a frame not ACKed within this time (ms)
+#ifndef RPC_COBS_RETRY_MS
+  #define RPC_COBS_RETRY_MS 50
+#endif
+
+// Retransmissions before a frame is given up
+#ifndef RPC_COBS_MAX_RETRIES
+  #define RPC_COBS_MAX_RETRIES 3
+#endif
+
+// ============================================================================
+// Response Cache
+// ============================================================================
+
+// Number of cached results
+#ifndef RPC_CACHE_ENTRIES
+  #define RPC_CACHE_ENTRIES 4
+#endif
+
+// Largest encoded result that can be cached (bytes per entry)
+#ifndef RPC_CACHE_ENTRY_SIZE
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_CACHE_ENTRY_SIZE 256
+  #else
+    #define RPC_CACHE_ENTRY_SIZE 64
+  #endif
+#endif
+
+// ============================================================================
+// Subscriptions
+// ============================================================================
+
+// Topics a server can publish (RPC_ENABLE_PUBSUB)
+#ifndef RPC_MAX_TOPICS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_TOPICS 4
+  #else
+    #define RPC_MAX_TOPICS 2
+  #endif
+#endif
+
+// Subscriptions held by a server, across all topics and transports
+#ifndef RPC_MAX_SUBSCRIPTIONS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_SUBSCRIPTIONS 8
+  #else
+    #define RPC_MAX_SUBSCRIPTIONS 2
+  #endif
+#endif
+
+// Notification callbacks a client can register (RpcClient::onNotification)
+#ifndef RPC_MAX_LISTENERS
+  #if defined(ESP32) || defined(ESP8266)
+    #define RPC_MAX_LISTENERS 4
+  #else
+    #define RPC_MAX_LISTENERS 2
+  #endif
+#endif
+
+// ============================================================================
+// Threaded Server (ESP32)
+// ============================================================================
+
+// Run parsing/dispatch on a dedicated worker task (see RpcWorker.h)
+// Not combinable with RPC_ENABLE_CACHE, RPC_ENABLE_PUBSUB or RPC_ENABLE_METRICS
+#ifndef RPC_ENABLE_THREADED
+  #define RPC_ENABLE_THREADED 0  // Disabled by default (ESP32 only)
+#endif
+
+// Request/reply slots between the worker and loop() (power of two)
+#ifndef RPC_WORKER_QUEUE_SIZE
+  #define RPC_WORKER_QUEUE_SIZE 2
+#endif
+
+// Worker task stack size in bytes
+#ifndef RPC_WORKER_STACK_SIZE
+  #define RPC_WORKER_STACK_SIZE 8192
+#endif
+
+// Core the worker task is pinned to (Arduino loop() runs on core 1)
+#ifndef RPC_WORKER_CORE
+  #define RPC_WORKER_CORE 0
+#endif
+
 // ============================================================================
 // ArduinoJson Configuration
 // ============================================================================
 
-// Use StaticJsonDocument for better performance and predictable memory
+// Per-request documents are RpcDocument<RPC_JSON_DOC_SIZE>: on the stack, or
+// carved from the RpcMemoryPool arena with RPC_ENABLE_MEMORY_POOL
 // Size based on RPC_MAX_REQUEST_SIZE
 #define RPC_JSON_DOC_SIZE (RPC_MAX_REQUEST_SIZE + 256)
 
+// Request document for in-situ parsing: only the tree lives in the pool,
+// the strings stay in the transport buffer
+#ifndef RPC_IN_SITU_DOC_SIZE
+  #define RPC_IN_SITU_DOC_SIZE (RPC_JSON_DOC_SIZE / 2)
+#endif
+
 // ============================================================================
 // Logging Macros
 // ============================================================================
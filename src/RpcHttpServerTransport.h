@@ -0,0 +1,438 @@
+/**
+ * RPC Arduino Toolkit - HTTP Keep-Alive Server Transport
+ * 
+ * HTTP/1.1 server transport with persistent connections:
+ * - Requests are parsed incrementally, the body is read by Content-Length
+ *   (bodies split across TCP segments are reassembled)
+ * - Several sequential (or pipelined) requests per connection
+ * - Up to RPC_HTTP_MAX_CONNECTIONS clients served from a fixed table
+ * 
+ * read() returns the body of the next complete request from any
+ * connection; write() answers the connection that request came from.
+ * 
+ * The transport is a template over the server/client socket types, so it
+ * can run on anything shaped like WiFiServer/WiFiClient (e.g. a loopback
+ * stand-in on the host). RpcHttpServerTransport is the WiFi instantiation.
+ */
+
+#ifndef RPC_HTTP_SERVER_TRANSPORT_H
+#define RPC_HTTP_SERVER_TRANSPORT_H
+
+#include "RpcTransport.h"
+
+template<typename TServer, typename TClient, uint8_t MAX_CONNECTIONS = RPC_HTTP_MAX_CONNECTIONS>
+class RpcHttpServerTransportT : public RpcTransport {
+private:
+    enum State : uint8_t {
+        STATE_FREE,           // Slot unused
+        STATE_REQUEST_LINE,   // Waiting for "POST / HTTP/1.1"
+        STATE_HEADERS,        // Reading header lines
+        STATE_BODY,           // Reading Content-Length bytes
+        STATE_DISCARD,        // Skipping the body of a rejected request
+        STATE_READY,          // Complete request, waiting to be read()
+        STATE_REPLY           // Request handed out, waiting for write()
+    };
+    
+    struct Connection {
+        TClient client;
+        State state;
+        bool keepAlive;
+        int16_t status;            // Error status to answer with (0 = none)
+        size_t contentLength;
+        size_t len;                // Bytes of the current line/body in buffer
+        unsigned long lastActivity;
+        char buffer[RPC_MAX_REQUEST_SIZE];
+    };
+    
+    TServer& server;
+    Connection connections[MAX_CONNECTIONS];
+    uint8_t current;               // Connection answered by write()
+    uint8_t nextScan;              // Round-robin start for fairness
+    uint32_t dropped;              // Requests rejected as too large (413)
+    
+    static bool startsWithIgnoreCase(const char* s, const char* prefix) {
+        while (*prefix) {
+            if (tolower((unsigned char)*s++) != tolower((unsigned char)*prefix++)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    static bool containsIgnoreCase(const char* s, const char* needle) {
+        for (; *s; s++) {
+            if (startsWithIgnoreCase(s, needle)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // One write: piecewise prints would each go out as a small TCP segment
+    void sendHead(Connection& c, int status, const char* reason, size_t length, const char* contentType) {
+        char head[160];
+        int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: %s\r\n\r\n",
+                         status, reason, contentType, (unsigned)length, c.keepAlive ? "keep-alive" : "close");
+        c.client.write((const uint8_t*)head, n);
+    }
+    
+    // Reset the slot for the next request on the same connection
+    // (no client.flush(): on ESP32 it discards unread, pipelined requests)
+    void finishRequest(Connection& c) {
+        if (!c.keepAlive) {
+            close(c);
+            return;
+        }
+        c.state = STATE_REQUEST_LINE;
+        c.len = 0;
+        c.status = 0;
+        c.contentLength = 0;
+        c.lastActivity = millis();
+    }
+    
+    void sendError(Connection& c, int status, const char* reason) {
+        sendHead(c, status, reason, 0, "text/plain");
+        finishRequest(c);
+    }
+    
+    void close(Connection& c) {
+        c.client.stop();
+        c.state = STATE_FREE;
+    }
+    
+    const char* contentType() const {
+        return format == RPC_FORMAT_MSGPACK ? "application/msgpack" : "application/json";
+    }
+    
+    // Handle one complete request or header line (without "\r\n")
+    void processLine(Connection& c) {
+        c.buffer[c.len] = '\0';
+        
+        if (c.state == STATE_REQUEST_LINE) {
+            if (c.len == 0) {
+                return;  // Tolerate stray CRLF between pipelined requests
+            }
+            // HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close
+            c.keepAlive = !containsIgnoreCase(c.buffer, "HTTP/1.0");
+            c.status = startsWithIgnoreCase(c.buffer, "POST ") ? 0 : 405;
+            c.contentLength = 0;
+            c.state = STATE_HEADERS;
+            return;
+        }
+        
+        // STATE_HEADERS
+        if (c.len > 0) {
+            if (startsWithIgnoreCase(c.buffer, "Content-Length:")) {
+                c.contentLength = strtoul(c.buffer + 15, nullptr, 10);
+            } else if (startsWithIgnoreCase(c.buffer, "Connection:")) {
+                if (containsIgnoreCase(c.buffer, "close")) {
+                    c.keepAlive = false;
+                } else if (containsIgnoreCase(c.buffer, "keep-alive")) {
+                    c.keepAlive = true;
+                }
+            }
+            return;
+        }
+        
+        // Blank line: end of headers
+        if (c.status == 0 && c.contentLength == 0) {
+            c.status = 411;
+        } else if (c.status == 0 && c.contentLength >= sizeof(c.buffer)) {
+            c.status = 413;
+            dropped++;
+        }
+        
+        c.state = c.status == 0 ? STATE_BODY : STATE_DISCARD;
+    }
+    
+    void replyStatus(Connection& c) {
+        switch (c.status) {
+            case 405: sendError(c, 405, "Method Not Allowed"); break;
+            case 411: sendError(c, 411, "Length Required"); break;
+            case 413: sendError(c, 413, "Payload Too Large"); break;
+            default: sendError(c, 400, "Bad Request"); break;
+        }
+    }
+    
+    /**
+     * Consume the bytes already received on a connection (never blocks)
+     * Stops at the end of a request body, so pipelined requests stay in
+     * the socket buffer until this one has been answered.
+     */
+    bool step(Connection& c) {
+        while (c.state != STATE_READY && c.state != STATE_REPLY && c.client.available() > 0) {
+            int ch = c.client.read();
+            if (ch < 0) {
+                break;
+            }
+            c.lastActivity = millis();
+            
+            if (c.state == STATE_BODY) {
+                c.buffer[c.len++] = (char)ch;
+                if (c.len == c.contentLength) {
+                    c.buffer[c.len] = '\0';
+                    c.state = STATE_READY;
+                }
+                continue;
+            }
+            
+            if (c.state == STATE_DISCARD) {
+                if (c.contentLength > 0) {
+                    c.contentLength--;
+                }
+                if (c.contentLength == 0) {
+                    replyStatus(c);
+                    if (c.state == STATE_FREE) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            
+            // Request line / headers
+            if (ch == '\n') {
+                if (c.len > 0 && c.buffer[c.len - 1] == '\r') {
+                    c.len--;
+                }
+                processLine(c);
+                c.len = 0;
+                
+                // Rejected request without a body: answer right away
+                if (c.state == STATE_DISCARD && c.contentLength == 0) {
+                    replyStatus(c);
+                    if (c.state == STATE_FREE) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            
+            // Lines longer than the buffer are truncated: only the
+            // header name and a short value matter here
+            if (c.len < sizeof(c.buffer) - 1) {
+                c.buffer[c.len++] = (char)ch;
+            }
+        }
+        
+        return c.state == STATE_READY;
+    }
+    
+    void acceptClients() {
+        TClient client = server.available();
+        if (!client) {
+            return;
+        }
+        
+        for (uint8_t i = 0; i < MAX_CONNECTIONS; i++) {
+            if (connections[i].state == STATE_FREE) {
+                Connection& c = connections[i];
+                c.client = client;
+                c.state = STATE_REQUEST_LINE;
+                c.keepAlive = true;
+                c.status = 0;
+                c.contentLength = 0;
+                c.len = 0;
+                c.lastActivity = millis();
+                RPC_LOG_F("HTTP connection %u opened", i);
+                return;
+            }
+        }
+        
+        // Connection table full
+        RPC_LOG("HTTP connection table full");
+        client.print("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        client.stop();
+    }
+    
+    // Service every connection and return the index of a ready request
+    int findReady() {
+        // A request handed out but never answered (e.g. a notification):
+        // HTTP still needs a response before the next one
+        if (current < MAX_CONNECTIONS && connections[current].state == STATE_REPLY) {
+            sendHead(connections[current], 204, "No Content", 0, contentType());
+            finishRequest(connections[current]);
+        }
+        
+        acceptClients();
+        
+        for (uint8_t n = 0; n < MAX_CONNECTIONS; n++) {
+            uint8_t i = (nextScan + n) % MAX_CONNECTIONS;
+            Connection& c = connections[i];
+            if (c.state == STATE_FREE) {
+                continue;
+            }
+            
+            if (!c.client.connected() && c.client.available() <= 0) {
+                close(c);
+                continue;
+            }
+            
+            if (step(c)) {
+                nextScan = (i + 1) % MAX_CONNECTIONS;
+                return i;
+            }
+            
+            // Read the clock after step(): it moves lastActivity forward
+            if (c.state != STATE_FREE && millis() - c.lastActivity >= timeout) {
+                RPC_LOG_F("HTTP connection %u idle, closing", i);
+                close(c);
+            }
+        }
+        
+        return -1;
+    }
+    
+    // Hand the ready request out and remember where to reply
+    Connection* take() {
+        int i = findReady();
+        if (i < 0) {
+            return nullptr;
+        }
+        current = (uint8_t)i;
+        connections[i].state = STATE_REPLY;
+        return &connections[i];
+    }
+    
+public:
+    explicit RpcHttpServerTransportT(TServer& s) : server(s), current(MAX_CONNECTIONS), nextScan(0), dropped(0) {
+        for (uint8_t i = 0; i < MAX_CONNECTIONS; i++) {
+            connections[i].state = STATE_FREE;
+        }
+        setTimeout(RPC_HTTP_KEEPALIVE_TIMEOUT);
+    }
+    
+    String read() override {
+        Connection* c = take();
+        if (!c) {
+            return "";
+        }
+        
+        String result;
+        result.reserve(c->len);
+        RpcCodec::appendBytes(result, (const uint8_t*)c->buffer, c->len);
+        
+        RPC_LOG_F("HTTP RX: %s", c->buffer);
+        return result;
+    }
+    
+    size_t readFrame(char* buf, size_t cap) override {
+        if (cap == 0) {
+            return 0;
+        }
+        
+        Connection* c = take();
+        if (!c) {
+            return 0;
+        }
+        
+        // Too large for the caller: answered here, as a body over the limit
+        if (c->len >= cap) {
+            dropped++;
+            sendError(*c, 413, "Payload Too Large");
+            return 0;
+        }
+        
+        memcpy(buf, c->buffer, c->len);
+        buf[c->len] = '\0';
+        return c->len;
+    }
+    
+    bool hasFrameBuffer() const override {
+        return true;
+    }
+    
+    // The body stays in the connection buffer until the reply is written
+    // and the next request is read, so releaseFrame() has nothing to do
+    char* peekFrame(size_t& len) override {
+        Connection* c = take();
+        len = c ? c->len : 0;
+        return c ? c->buffer : nullptr;
+    }
+    
+    bool writeFrame(const char* data, size_t len) override {
+        if (current >= MAX_CONNECTIONS || connections[current].state != STATE_REPLY) {
+            return false;
+        }
+        
+        Connection& c = connections[current];
+        RPC_LOG_F("HTTP TX: %.*s", (int)len, data);
+        
+        if (len == 0) {
+            sendHead(c, 204, "No Content", 0, contentType());
+        } else {
+            sendHead(c, 200, "OK", len, contentType());
+            c.client.write((const uint8_t*)data, len);
+        }
+        finishRequest(c);
+        return true;
+    }
+    
+    bool writeDocument(JsonVariantConst doc) override {
+        if (current >= MAX_CONNECTIONS || connections[current].state != STATE_REPLY) {
+            return false;
+        }
+        
+        // Content-Length up front, then serialize straight into the socket
+        Connection& c = connections[current];
+        sendHead(c, 200, "OK", RpcCodec::measure(doc, format), contentType());
+        {
+            RpcBufferedPrint<> out(c.client);
+            RpcCodec::encode(doc, out, format);
+        }
+        finishRequest(c);
+        return true;
+    }
+    
+    bool write(const String& data) override {
+        return writeFrame(data.c_str(), data.length());
+    }
+    
+    // Every write answers a request: nothing can be pushed
+    bool canPush() const override {
+        return false;
+    }
+    
+    bool available() override {
+        for (uint8_t i = 0; i < MAX_CONNECTIONS; i++) {
+            State state = connections[i].state;
+            if (state == STATE_READY || (state != STATE_FREE && connections[i].client.available() > 0)) {
+                return true;
+            }
+        }
+        return server.hasClient();
+    }
+    
+    uint32_t takeDroppedFrames() override {
+        uint32_t count = dropped;
+        dropped = 0;
+        return count;
+    }
+    
+    /**
+     * Number of open client connections
+     */
+    uint8_t connectionCount() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < MAX_CONNECTIONS; i++) {
+            if (connections[i].state != STATE_FREE) {
+                count++;
+            }
+        }
+        return count;
+    }
+};
+
+#if RPC_HAS_WIFI
+
+#if defined(ESP32)
+  #include <WiFi.h>
+#elif defined(ESP8266)
+  #include <ESP8266WiFi.h>
+#endif
+
+typedef RpcHttpServerTransportT<WiFiServer, WiFiClient> RpcHttpServerTransport;
+
+#endif // RPC_HAS_WIFI
+
+#endif // RPC_HTTP_SERVER_TRANSPORT_H
@@ -0,0 +1,93 @@
+/**
+ * RPC Arduino Toolkit - Loopback Transport
+ * 
+ * In-memory transport that hands every written frame to a responder
+ * (typically an RpcServer) and queues its reply for read(). Lets an
+ * RpcClient talk to a server in the same sketch: benchmarks, self-tests
+ * and local dispatch without any hardware link.
+ * 
+ * Usage:
+ *   RpcServer<8> rpc;
+ *   RpcLoopbackTransport loopback([](const String& request) {
+ *       return rpc.handleRequest(request);
+ *   });
+ *   RpcClient client(loopback);
+ */
+
+#ifndef RPC_LOOPBACK_TRANSPORT_H
+#define RPC_LOOPBACK_TRANSPORT_H
+
+#include "RpcTransport.h"
+
+// Produces the reply for one request frame ("" for none)
+typedef std::function<String(const String&)> RpcLoopbackResponder;
+
+class RpcLoopbackTransport : public RpcTransport {
+private:
+    static const uint8_t QUEUE_SIZE = RPC_MAX_PENDING_CALLS;
+    
+    RpcLoopbackResponder responder;
+    String queue[QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint32_t bytesOut;
+    uint32_t bytesIn;
+    
+public:
+    explicit RpcLoopbackTransport(RpcLoopbackResponder r)
+        : responder(r), head(0), count(0), bytesOut(0), bytesIn(0) {}
+    
+    String read() override {
+        if (count == 0) {
+            return "";
+        }
+        
+        String frame = queue[head];
+        queue[head] = "";
+        head = (head + 1) % QUEUE_SIZE;
+        count--;
+        
+        bytesIn += frame.length();
+        return frame;
+    }
+    
+    bool write(const String& data) override {
+        bytesOut += data.length();
+        
+        String reply = responder(data);
+        if (reply.isEmpty()) {
+            return true;
+        }
+        
+        if (count == QUEUE_SIZE) {
+            RPC_LOG("Loopback queue full, dropping reply");
+            return false;
+        }
+        
+        queue[(head + count) % QUEUE_SIZE] = reply;
+        count++;
+        return true;
+    }
+    
+    bool available() override {
+        return count > 0;
+    }
+    
+    /**
+     * Bytes written to / read from the transport (wire size accounting)
+     */
+    uint32_t bytesWritten() const {
+        return bytesOut;
+    }
+    
+    uint32_t bytesRead() const {
+        return bytesIn;
+    }
+    
+    void resetCounters() {
+        bytesOut = 0;
+        bytesIn = 0;
+    }
+};
+
+#endif // RPC_LOOPBACK_TRANSPORT_H
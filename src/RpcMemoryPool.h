@@ -0,0 +1,262 @@
+/**
+ * RPC Arduino Toolkit - Memory Pool
+ * 
+ * One arena for every per-request JSON document. With
+ * RPC_ENABLE_MEMORY_POOL, RpcDocument<N> is a BasicJsonDocument whose
+ * pool is carved from the default RpcMemoryPool instead of the stack, so
+ * peak RPC memory is the arena size, wherever the arena lives (static
+ * RAM, PSRAM, a heap block taken once at boot).
+ * 
+ * The arena is a stack: blocks are handed out by bumping a pointer and
+ * reclaimed when every block above them has been freed. Documents live
+ * for the duration of a request, so the arena is empty again after each
+ * one.
+ * 
+ * Usage:
+ *   #define RPC_ENABLE_MEMORY_POOL 1
+ *   RpcStaticPool<4096> arena;              // or RpcMemoryPool arena(ps_malloc(n), n);
+ *   void setup() { RpcMemoryPool::setDefault(&arena); }
+ */
+
+#ifndef RPC_MEMORY_POOL_H
+#define RPC_MEMORY_POOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "RpcConfig.h"
+
+#if RPC_ENABLE_MEMORY_POOL && RPC_ENABLE_THREADED
+  #error "RPC_ENABLE_MEMORY_POOL cannot be combined with RPC_ENABLE_THREADED (the arena is not shared between tasks)"
+#endif
+
+// ============================================================================
+// Arena
+// ============================================================================
+
+class RpcMemoryPool {
+private:
+    // Precedes every block; prev links blocks so freed ones can be popped
+    struct Header {
+        uint32_t prev;   // Offset of the previous block's header, NONE if first
+        uint32_t freed;  // Non-zero once deallocated
+    };
+    
+    static const uint32_t NONE = 0xFFFFFFFF;
+    static const size_t ALIGN = 8;
+    
+    uint8_t* base;
+    size_t capacity;
+    size_t top;       // First free byte
+    uint32_t last;    // Header offset of the topmost block
+    size_t peak;
+    
+    static size_t align(size_t n) {
+        return (n + ALIGN - 1) & ~(ALIGN - 1);
+    }
+    
+    Header* header(uint32_t offset) {
+        return (Header*)(base + offset);
+    }
+    
+    // Drop freed blocks from the top of the stack
+    void collapse() {
+        while (last != NONE && header(last)->freed) {
+            top = last;
+            last = header(last)->prev;
+        }
+    }
+    
+public:
+    /**
+     * @param buffer Arena storage (any RAM; aligned to 8 bytes internally)
+     * @param size Size of buffer in bytes
+     */
+    RpcMemoryPool(void* buffer, size_t size) : base((uint8_t*)buffer), capacity(size), peak(0) {
+        // Start on an aligned address
+        size_t skew = (ALIGN - ((uintptr_t)base & (ALIGN - 1))) & (ALIGN - 1);
+        if (!base || skew >= size) {
+            base = nullptr;
+            capacity = 0;
+        } else {
+            base += skew;
+            capacity = size - skew;
+        }
+        reset();
+    }
+    
+    /**
+     * Allocate n bytes, nullptr if the arena is exhausted
+     */
+    void* allocate(size_t n) {
+        size_t start = top + sizeof(Header);
+        size_t end = start + align(n);
+        if (end > capacity) {
+            RPC_LOG_F("Memory pool exhausted (%u of %u bytes used)", (unsigned)top, (unsigned)capacity);
+            return nullptr;
+        }
+        
+        Header* h = header(top);
+        h->prev = last;
+        h->freed = 0;
+        last = top;
+        top = end;
+        if (top > peak) {
+            peak = top;
+        }
+        return base + start;
+    }
+    
+    /**
+     * Free a block; its memory is reused once the blocks above it are freed
+     */
+    void deallocate(void* p) {
+        if (!p) {
+            return;
+        }
+        ((Header*)((uint8_t*)p - sizeof(Header)))->freed = 1;
+        collapse();
+    }
+    
+    /**
+     * Resize a block: in place for the topmost block, otherwise only
+     * shrinking is supported (as done by JsonDocument::shrinkToFit)
+     */
+    void* reallocate(void* p, size_t n) {
+        if (!p) {
+            return allocate(n);
+        }
+        
+        uint32_t offset = (uint8_t*)p - base - sizeof(Header);
+        if (offset == last) {
+            size_t end = offset + sizeof(Header) + align(n);
+            if (end > capacity) {
+                return nullptr;
+            }
+            top = end;
+            if (top > peak) {
+                peak = top;
+            }
+            return p;
+        }
+        
+        // Below the top: the block ends where the block above it starts
+        uint32_t above = last;
+        while (header(above)->prev != offset) {
+            above = header(above)->prev;
+        }
+        return offset + sizeof(Header) + n <= above ? p : nullptr;
+    }
+    
+    /**
+     * Whether p points into this arena
+     */
+    bool owns(const void* p) const {
+        return p >= base && p < base + capacity;
+    }
+    
+    /**
+     * Free every block at once (only when no document is alive)
+     */
+    void reset() {
+        top = 0;
+        last = NONE;
+    }
+    
+    /**
+     * Bytes currently in use (blocks plus headers)
+     */
+    size_t used() const {
+        return top;
+    }
+    
+    /**
+     * Usable arena size
+     */
+    size_t size() const {
+        return capacity;
+    }
+    
+    /**
+     * Highest used() seen: size the arena from this figure
+     */
+    size_t highWaterMark() const {
+        return peak;
+    }
+    
+    /**
+     * Arena the RpcDocument allocator draws from (nullptr = heap)
+     */
+    static RpcMemoryPool*& defaultPool() {
+        static RpcMemoryPool* pool = nullptr;
+        return pool;
+    }
+    
+    /**
+     * Make pool the arena for all RPC documents; call before serving
+     */
+    static void setDefault(RpcMemoryPool* pool) {
+        defaultPool() = pool;
+    }
+};
+
+/**
+ * Arena with its own storage, for static RAM
+ */
+template<size_t SIZE>
+class RpcStaticPool : public RpcMemoryPool {
+private:
+    alignas(8) uint8_t storage[SIZE];
+    
+public:
+    RpcStaticPool() : RpcMemoryPool(storage, SIZE) {}
+};
+
+// ============================================================================
+// ArduinoJson Allocator
+// ============================================================================
+
+// Draws from the RpcMemoryPool::defaultPool() current when the document
+// was created, or the heap if none was set. Blocks go back to where they
+// came from, so setDefault() can change while documents are alive.
+struct RpcPoolAllocator {
+    RpcMemoryPool* pool;
+    
+    RpcPoolAllocator() : pool(RpcMemoryPool::defaultPool()) {}
+    
+    void* allocate(size_t n) {
+        return pool ? pool->allocate(n) : malloc(n);
+    }
+    
+    void deallocate(void* p) {
+        if (pool && pool->owns(p)) {
+            pool->deallocate(p);
+        } else {
+            free(p);
+        }
+    }
+    
+    void* reallocate(void* p, size_t n) {
+        if (!p) {
+            return allocate(n);
+        }
+        return pool && pool->owns(p) ? pool->reallocate(p, n) : realloc(p, n);
+    }
+};
+
+// ============================================================================
+// Document Type
+// ============================================================================
+
+// Every per-request document in the toolkit is an RpcDocument<CAPACITY>
+#if RPC_ENABLE_MEMORY_POOL
+template<size_t CAPACITY>
+class RpcDocument : public BasicJsonDocument<RpcPoolAllocator> {
+public:
+    RpcDocument() : BasicJsonDocument<RpcPoolAllocator>(CAPACITY) {}
+};
+#else
+template<size_t CAPACITY>
+using RpcDocument = StaticJsonDocument<CAPACITY>;
+#endif
+
+#endif // RPC_MEMORY_POOL_H
@@ -2,6 +2,17 @@
  * RPC Arduino Toolkit - Serial Transport
  * 
  * Transport over Serial/UART
+ * 
+ * Frames are newline-delimited and assembled incrementally: every call
+ * consumes only the bytes already received, so reads never block the loop.
+ * Keep the transport alive across loop() iterations (e.g. as a global),
+ * since a partially received frame is held inside it.
+ * 
+ * With RPC_FORMAT_MSGPACK (not newline-safe) every frame is instead
+ * prefixed with its length as 2 bytes, big-endian. A length prefix has
+ * no marker to resync on: after a lost or damaged byte the framer only
+ * realigns when the link pauses for the read timeout mid-frame. Use
+ * RpcCobsTransport on links that drop or corrupt bytes.
  */
 
 #ifndef RPC_SERIAL_TRANSPORT_H
@@ -14,37 +25,299 @@ private:
     Stream& serial;
     char buffer[RPC_MAX_REQUEST_SIZE];
     
+    // Incremental framer state
+    size_t rxLen;          // Bytes of the current frame in buffer
+    bool frameReady;       // buffer holds a complete, null-terminated frame
+    bool discarding;       // Dropping an oversize frame up to its newline
+    uint32_t dropped;      // Oversize (or, binary, stalled) frames discarded so far
+    uint32_t reported;     // Part of dropped already taken by the server
+    uint8_t headerBytes;   // Length-prefix bytes received (binary framing)
+    uint16_t frameSize;    // Announced frame length (binary framing)
+    unsigned long lastByte; // Arrival of the previous byte (binary framing)
+    
+    /**
+     * Length-prefixed variant of pollFrame() for binary formats
+     * Oversize frames are skipped by counting off their announced length.
+     * A frame still incomplete when the link has been quiet for the read
+     * timeout is dropped, so the next byte is taken as a new length prefix.
+     */
+    bool pollBinaryFrame() {
+        while (serial.available() > 0) {
+            int c = serial.read();
+            if (c < 0) {
+                break;
+            }
+            
+            unsigned long now = millis();
+            if (headerBytes > 0 && now - lastByte >= timeout) {
+                RPC_LOG("Serial frame stalled, resyncing");
+                if (!discarding) {
+                    dropped++;
+                }
+                consumeFrame();
+                discarding = false;
+            }
+            lastByte = now;
+            
+            if (headerBytes < 2) {
+                frameSize = (uint16_t)((frameSize << 8) | (uint8_t)c);
+                if (++headerBytes < 2) {
+                    continue;
+                }
+                
+                if (frameSize >= sizeof(buffer)) {
+                    RPC_LOG("Serial frame too large, discarding");
+                    discarding = true;
+                    dropped++;
+                } else if (frameSize == 0) {
+                    headerBytes = 0;
+                }
+                continue;
+            }
+            
+            if (discarding) {
+                if (--frameSize == 0) {
+                    discarding = false;
+                    headerBytes = 0;
+                }
+                continue;
+            }
+            
+            buffer[rxLen++] = (char)c;
+            if (rxLen == frameSize) {
+                buffer[rxLen] = '\0';
+                frameReady = true;
+                return true;
+            }
+        }
+        
+        return false;
+    }
+    
+    // Write the 2-byte length prefix used by binary formats
+    void writeLengthPrefix(size_t len) {
+        serial.write((uint8_t)(len >> 8));
+        serial.write((uint8_t)(len & 0xFF));
+    }
+    
+    /**
+     * Consume available bytes until a frame completes (never blocks)
+     * Bytes after the terminating newline stay in the Stream's own
+     * receive buffer until the next frame is requested.
+     */
+    bool pollFrame() {
+        if (frameReady) {
+            return true;
+        }
+        
+        if (format != RPC_FORMAT_JSON) {
+            return pollBinaryFrame();
+        }
+        
+        while (serial.available() > 0) {
+            int c = serial.read();
+            if (c < 0) {
+                break;
+            }
+            
+            if (c == '\n') {
+                if (discarding) {
+                    discarding = false;
+                    rxLen = 0;
+                    continue;
+                }
+                
+                // Trim trailing whitespace (e.g. '\r'), skip blank lines
+                while (rxLen > 0 && isspace((unsigned char)buffer[rxLen - 1])) {
+                    rxLen--;
+                }
+                if (rxLen == 0) {
+                    continue;
+                }
+                
+                buffer[rxLen] = '\0';
+                frameReady = true;
+                return true;
+            }
+            
+            // println() line ending: not stored, so a frame can use the whole
+            // buffer (JSON escapes CR inside strings)
+            if (c == '\r' || discarding) {
+                continue;
+            }
+            
+            // Skip leading whitespace
+            if (rxLen == 0 && isspace(c)) {
+                continue;
+            }
+            
+            if (rxLen >= sizeof(buffer) - 1) {
+                RPC_LOG("Serial frame too large, discarding");
+                discarding = true;
+                dropped++;
+                rxLen = 0;
+                continue;
+            }
+            
+            buffer[rxLen++] = (char)c;
+        }
+        
+        return false;
+    }
+    
 public:
-    explicit RpcSerialTransport(Stream& s) : serial(s) {
+    explicit RpcSerialTransport(Stream& s)
+        : serial(s), rxLen(0), frameReady(false), discarding(false), dropped(0), reported(0),
+          headerBytes(0), frameSize(0), lastByte(0) {
         setTimeout(RPC_SERIAL_TIMEOUT);
     }
     
     String read() override {
-        if (!serial.available()) {
+        if (!pollFrame()) {
             return "";
         }
         
-        // Read until newline or timeout
-        size_t len = serial.readBytesUntil('\n', buffer, sizeof(buffer) - 1);
-        buffer[len] = '\0';
-        
-        String result(buffer);
-        result.trim();
+        String result;
+        if (format == RPC_FORMAT_JSON) {
+            result = buffer;
+        } else {
+            result.reserve(rxLen);
+            RpcCodec::appendBytes(result, (const uint8_t*)buffer, rxLen);
+        }
+        consumeFrame();
         
         RPC_LOG_F("Serial RX: %s", result.c_str());
         return result;
     }
     
+    size_t readFrame(char* buf, size_t cap) override {
+        if (cap == 0 || !pollFrame()) {
+            return 0;
+        }
+        
+        // Too large for the caller: dropped like an oversize frame
+        if (rxLen >= cap) {
+            RPC_LOG("Serial frame too large for buffer, discarding");
+            consumeFrame();
+            dropped++;
+            return 0;
+        }
+        
+        size_t len = rxLen;
+        memcpy(buf, buffer, len);
+        buf[len] = '\0';
+        consumeFrame();
+        
+        RPC_LOG_F("Serial RX: %s", buf);
+        return len;
+    }
+    
+    bool writeFrame(const char* data, size_t len) override {
+        RPC_LOG_F("Serial TX: %.*s", (int)len, data);
+        
+        if (format != RPC_FORMAT_JSON) {
+            writeLengthPrefix(len);
+            serial.write((const uint8_t*)data, len);
+        } else {
+            serial.write((const uint8_t*)data, len);
+            serial.println();
+        }
+        serial.flush();
+        return true;
+    }
+    
+    bool writeDocument(JsonVariantConst doc) override {
+        if (format != RPC_FORMAT_JSON) {
+            writeLengthPrefix(RpcCodec::measure(doc, format));
+            RpcCodec::encode(doc, serial, format);
+        } else {
+            RpcCodec::encode(doc, serial, format);
+            serial.println();
+        }
+        serial.flush();
+        return true;
+    }
+    
     bool write(const String& data) override {
         RPC_LOG_F("Serial TX: %s", data.c_str());
         
-        serial.println(data);
+        if (format != RPC_FORMAT_JSON) {
+            writeLengthPrefix(data.length());
+            serial.write((const uint8_t*)data.c_str(), data.length());
+        } else {
+            serial.println(data);
+        }
         serial.flush();
         return true;
     }
     
     bool available() override {
-        return serial.available() > 0;
+        return frameReady || serial.available() > 0;
+    }
+    
+    bool hasFrameBuffer() const override {
+        return true;
+    }
+    
+    char* peekFrame(size_t& len) override {
+        len = pollFrame() ? rxLen : 0;
+        return len ? buffer : nullptr;
+    }
+    
+    void releaseFrame() override {
+        consumeFrame();
+    }
+    
+    /**
+     * Check for a complete frame without copying it (non-blocking)
+     * @return true if frame()/frameLength() hold a complete frame
+     */
+    bool frameAvailable() {
+        return pollFrame();
+    }
+    
+    /**
+     * Current complete frame (valid until consumeFrame())
+     */
+    const char* frame() const {
+        return frameReady ? buffer : "";
+    }
+    
+    size_t frameLength() const {
+        return frameReady ? rxLen : 0;
+    }
+    
+    /**
+     * Release the current frame so the next one can be assembled
+     */
+    void consumeFrame() {
+        frameReady = false;
+        rxLen = 0;
+        headerBytes = 0;
+        frameSize = 0;
+    }
+    
+    /**
+     * Switch framing with the wire format (drops any partial frame)
+     */
+    void setFormat(RpcFormat f) override {
+        RpcTransport::setFormat(f);
+        consumeFrame();
+        discarding = false;
+    }
+    
+    /**
+     * Number of frames dropped for exceeding RPC_MAX_REQUEST_SIZE (and, with
+     * binary framing, left incomplete when the link went quiet)
+     */
+    uint32_t droppedFrames() const {
+        return dropped;
+    }
+    
+    uint32_t takeDroppedFrames() override {
+        uint32_t count = dropped - reported;
+        reported = dropped;
+        return count;
     }
 };
 
@@ -9,6 +9,19 @@
 #include "RpcConfig.h"
 #include "RpcTypes.h"
 #include "RpcTransport.h"
+#include "RpcTypedMethod.h"
+
+#if RPC_ENABLE_CACHE && RPC_ENABLE_THREADED
+  #error "RPC_ENABLE_CACHE cannot be combined with RPC_ENABLE_THREADED (the cache is not shared between tasks)"
+#endif
+
+#if RPC_ENABLE_PUBSUB && RPC_ENABLE_THREADED
+  #error "RPC_ENABLE_PUBSUB cannot be combined with RPC_ENABLE_THREADED (subscriptions are not shared between tasks)"
+#endif
+
+#if RPC_ENABLE_METRICS && RPC_ENABLE_THREADED
+  #error "RPC_ENABLE_METRICS cannot be combined with RPC_ENABLE_THREADED (counters are updated from both tasks without locking)"
+#endif
 
 // ============================================================================
 // RPC Server
@@ -17,189 +30,784 @@
 template<uint8_t MAX_METHODS = RPC_MAX_METHODS>
 class RpcServer {
 private:
+    // Names and descriptions are held by pointer: into the copy buffers
+    // (RPC_COPY_METHOD_NAMES), to the caller's string, or to flash when
+    // registered with F()/FPSTR() (flashText set, read with the *_P calls)
     struct Method {
-        char name[RPC_MAX_METHOD_NAME];
-        RpcMethodHandler handler;
+        const char* name;
+        uint32_t hash;
+        RpcCheckedHandler handler;
         bool active;
+        bool flashText;
+#if RPC_COPY_METHOD_NAMES
+        char nameBuf[RPC_MAX_METHOD_NAME];
+#endif
+#if RPC_ENABLE_THREADED
+        RpcExecContext context;
+#endif
+#if RPC_ENABLE_CACHE
+        uint32_t cacheTtl;  // Result lifetime in ms, 0 = not cached
+#endif
+#if RPC_ENABLE_METRICS
+        RpcMethodStats stats;
+#endif
 #if RPC_ENABLE_SCHEMA_SUPPORT
-        char description[RPC_MAX_DESCRIPTION];
+        const char* description;
         bool exposeSchema;
+#if RPC_COPY_METHOD_NAMES
+        char descriptionBuf[RPC_MAX_DESCRIPTION];
+#endif
 #endif
     };
     
     Method methods[MAX_METHODS];
     uint8_t methodCount;
+#if RPC_ENABLE_METHOD_IDS
+    uint16_t generation;  // Bumped by removeMethod(): IDs handed out earlier go stale
+#endif
     
-    // Parse request from JSON
-    bool parseRequest(const String& json, RpcRequest& req, StaticJsonDocument<RPC_JSON_DOC_SIZE>& doc) {
-        DeserializationError error = deserializeJson(doc, json);
-        if (error) {
-            RPC_LOG_F("Parse error: %s", error.c_str());
+    // Transports served by poll(), kept packed; round-robin start for fairness
+    RpcTransport* transports[RPC_MAX_TRANSPORTS];
+    uint8_t transportCount;
+    uint8_t nextTransport;
+#if RPC_ENABLE_METRICS
+    RpcServerStats stats;
+#endif
+    
+#if RPC_ENABLE_CACHE
+    // Response cache: encoded results of idempotent methods, keyed by method
+    // slot + params hash + wire format, in a fixed arena of entries.
+    // A hit only builds the envelope; the result bytes are spliced in raw.
+    static const uint8_t CACHE_FREE = 0xFF;
+    static const uint8_t CACHE_LIST_METHODS = MAX_METHODS;  // Pseudo-slot for __rpc.listMethods
+    
+    struct CacheEntry {
+        uint8_t slot;
+        RpcFormat format;
+        uint16_t length;
+        uint32_t paramsHash;
+        unsigned long expires;
+        char data[RPC_CACHE_ENTRY_SIZE];
+    };
+    
+    // Result produced by the last executeMethod() that may be stored once
+    // the caller knows the response document did not overflow
+    struct CachePending {
+        bool armed;
+        uint8_t slot;
+        uint32_t paramsHash;
+        uint32_t ttl;
+        RpcFormat format;
+    };
+    
+    CacheEntry cache[RPC_CACHE_ENTRIES];
+    CachePending cachePending;
+    uint32_t listMethodsTtl;
+    
+    CacheEntry* cacheFind(uint8_t slot, uint32_t paramsHash, RpcFormat format) {
+        unsigned long now = millis();
+        for (CacheEntry& entry : cache) {
+            if (entry.slot != slot || entry.paramsHash != paramsHash || entry.format != format) {
+                continue;
+            }
+            if ((long)(now - entry.expires) >= 0) {
+                entry.slot = CACHE_FREE;
+                return nullptr;
+            }
+            return &entry;
+        }
+        return nullptr;
+    }
+    
+    // Answer from the cache; on a miss arm cachePending so the fresh
+    // result gets stored by cacheCommit()
+    bool cacheLookup(uint8_t slot, uint32_t paramsHash, uint32_t ttl, RpcFormat format,
+                     JsonObject out, JsonVariantConst id) {
+        CacheEntry* entry = cacheFind(slot, paramsHash, format);
+        if (!entry) {
+            cachePending = {true, slot, paramsHash, ttl, format};
+            return false;
+        }
+        
+        out["jsonrpc"] = "2.0";
+        out["result"] = serialized((char*)entry->data, entry->length);  // Copied: entries may be evicted
+        out["id"] = id;
+        return true;
+    }
+    
+    // Store the armed result unless the response document overflowed
+    void cacheCommit(const JsonDocument& doc, JsonVariantConst reply) {
+        if (!cachePending.armed) {
+            return;
+        }
+        cachePending.armed = false;
+        
+        JsonVariantConst result = reply["result"];
+        if (doc.overflowed() || result.isNull()) {
+            return;
+        }
+        
+        size_t len = RpcCodec::measure(result, cachePending.format);
+        if (len == 0 || len >= RPC_CACHE_ENTRY_SIZE) {
+            return;  // Does not fit in an arena entry
+        }
+        
+        // Victim: a free or expired entry, otherwise the one expiring soonest
+        unsigned long now = millis();
+        CacheEntry* victim = &cache[0];
+        for (CacheEntry& entry : cache) {
+            if (entry.slot == CACHE_FREE || (long)(now - entry.expires) >= 0) {
+                victim = &entry;
+                break;
+            }
+            if ((long)(entry.expires - victim->expires) < 0) {
+                victim = &entry;
+            }
+        }
+        
+        victim->length = RpcCodec::encode(result, victim->data, sizeof(victim->data), cachePending.format);
+        victim->slot = victim->length ? cachePending.slot : CACHE_FREE;
+        victim->format = cachePending.format;
+        victim->paramsHash = cachePending.paramsHash;
+        victim->expires = now + cachePending.ttl;
+    }
+    
+    void cacheInvalidate(uint8_t slot) {
+        for (CacheEntry& entry : cache) {
+            if (entry.slot == slot) {
+                entry.slot = CACHE_FREE;
+            }
+        }
+    }
+#endif
+    
+#if RPC_ENABLE_PUBSUB
+    // Topics are pulled, not buffered: publish() only marks subscriptions
+    // dirty and the producer writes the current value when a notification
+    // is due, so updates published faster than the interval (or than the
+    // link drains) coalesce into one message carrying the latest value.
+    struct Topic {
+        char name[RPC_MAX_METHOD_NAME];
+        uint32_t hash;
+        RpcTopicHandler producer;
+        bool active;
+    };
+    
+    // One client's interest in a topic, bound to the transport it came from
+    struct Subscription {
+        RpcTransport* transport;
+        uint32_t interval;       // Minimum ms between two notifications
+        unsigned long lastSent;
+        uint8_t topic;           // Slot in topics[]
+        bool dirty;              // Published since the last notification
+        bool active;
+    };
+    
+    Topic topics[RPC_MAX_TOPICS];
+    Subscription subscriptions[RPC_MAX_SUBSCRIPTIONS];
+    RpcTransport* origin;  // Transport of the request being handled, if any
+    
+    // Sets origin for the duration of serve()/handleRequest(transport)
+    struct OriginScope {
+        RpcTransport*& slot;
+        OriginScope(RpcTransport*& s, RpcTransport* t) : slot(s) { slot = t; }
+        ~OriginScope() { slot = nullptr; }
+    };
+    
+    Topic* findTopic(const char* name) {
+        uint32_t hash = RpcHash::compute(name);
+        for (Topic& topic : topics) {
+            if (topic.active && topic.hash == hash && strcmp(topic.name, name) == 0) {
+                return &topic;
+            }
+        }
+        return nullptr;
+    }
+    
+    Subscription* findSubscription(RpcTransport* transport, uint8_t topic) {
+        for (Subscription& sub : subscriptions) {
+            if (sub.active && sub.transport == transport && sub.topic == topic) {
+                return &sub;
+            }
+        }
+        return nullptr;
+    }
+    
+    // Named ({"topic":..,"interval":..}) or positional ([topic, interval]) param
+    static JsonVariant param(JsonVariant params, const char* name, size_t pos) {
+        if (params.is<JsonArray>()) {
+            return params[pos];
+        }
+        return params[name];
+    }
+    
+    // __rpc.subscribe / __rpc.unsubscribe on the transport the request came from
+    void handleSubscribe(RpcRequest& req, JsonObject out, bool subscribe) {
+        const char* name = param(req.params, "topic", 0) | "";
+        Topic* topic = findTopic(name);
+        if (!topic) {
+            RpcError::write(out, RPC_ERROR_INVALID_PARAMS, "Unknown topic", req.id);
+            return;
+        }
+        
+        uint8_t slot = topic - topics;
+        Subscription* sub = findSubscription(origin, slot);
+        
+        if (!subscribe) {
+            if (sub) {
+                sub->active = false;
+            }
+        } else if (!origin || !origin->canPush()) {
+            RpcError::write(out, RPC_ERROR_SERVER, "Transport cannot push", req.id);
+            return;
+        } else {
+            for (uint8_t i = 0; !sub && i < RPC_MAX_SUBSCRIPTIONS; i++) {
+                if (!subscriptions[i].active) {
+                    sub = &subscriptions[i];
+                }
+            }
+            if (!sub) {
+                RpcError::write(out, RPC_ERROR_SERVER, "Too many subscriptions", req.id);
+                return;
+            }
+            
+            // Due immediately: the subscriber gets the current value first
+            sub->transport = origin;
+            sub->topic = slot;
+            sub->interval = param(req.params, "interval", 1) | 0UL;
+            sub->lastSent = millis() - sub->interval;
+            sub->dirty = true;
+            sub->active = true;
+        }
+        
+        out["jsonrpc"] = "2.0";
+        out["result"] = sub != nullptr;
+        out["id"] = req.id;
+    }
+#endif
+    
+    // Open-addressed hash index over methods[] (slot numbers, linear probing).
+    // Twice as many buckets as methods keeps probe chains short.
+    static const uint16_t INDEX_SIZE = RpcHash::tableSize(2 * MAX_METHODS);
+    static const uint8_t INDEX_EMPTY = 0xFF;
+    static_assert(MAX_METHODS < INDEX_EMPTY, "MAX_METHODS must be below 255");
+    uint8_t index[INDEX_SIZE];
+    
+    void indexInsert(uint8_t slot) {
+        uint16_t pos = methods[slot].hash & (INDEX_SIZE - 1);
+        while (index[pos] != INDEX_EMPTY) {
+            pos = (pos + 1) & (INDEX_SIZE - 1);
+        }
+        index[pos] = slot;
+    }
+    
+    // Removals are rare: rebuild the index instead of keeping tombstones
+    void rebuildIndex() {
+        memset(index, INDEX_EMPTY, sizeof(index));
+        for (uint8_t i = 0; i < MAX_METHODS; i++) {
+            if (methods[i].active) {
+                indexInsert(i);
+            }
+        }
+    }
+    
+    // Find an active method by name; hash is RpcHash::compute(name)
+    Method* findMethod(const char* name, uint32_t hash) {
+        uint16_t pos = hash & (INDEX_SIZE - 1);
+        while (index[pos] != INDEX_EMPTY) {
+            Method& m = methods[index[pos]];
+            if (m.hash == hash && nameEquals(m, name)) {
+                return &m;
+            }
+            pos = (pos + 1) & (INDEX_SIZE - 1);
+        }
+        return nullptr;
+    }
+    
+#if RPC_ENABLE_METHOD_IDS
+    // Method ID: slot in the low byte, table generation above it
+    uint32_t methodIdOf(uint8_t slot) const {
+        return ((uint32_t)generation << 8) | slot;
+    }
+    
+    // Find an active method by ID; nullptr if unknown or from an older generation
+    Method* findMethodById(uint32_t id) {
+        uint8_t slot = id & 0xFF;
+        if ((id >> 8) != generation || slot >= MAX_METHODS || !methods[slot].active) {
+            return nullptr;
+        }
+        return &methods[slot];
+    }
+#endif
+    
+    static bool nameEquals(const Method& m, const char* name) {
+        return m.flashText ? strcmp_P(name, m.name) == 0 : strcmp(m.name, name) == 0;
+    }
+    
+    // Write method text into a reply: flash strings are copied into the
+    // document, RAM strings are linked
+    template<typename TDst>
+    static void setText(TDst dst, const Method& m, const char* text) {
+        if (!text) {
+            dst.set("");
+        } else if (m.flashText) {
+            dst.set((const __FlashStringHelper*)text);
+        } else {
+            dst.set(text);
+        }
+    }
+    
+    // Parse request from an already deserialized JSON object
+    bool parseRequest(JsonObject obj, RpcRequest& req) {
+        if (obj.isNull()) {
             return false;
         }
         
-        req.jsonrpc = doc["jsonrpc"] | "";
-        req.method = doc["method"] | "";
-        req.params = doc["params"].as<JsonObject>();
-        req.id = doc["id"];
+        req.jsonrpc = obj["jsonrpc"] | "";
+        req.method = obj["method"] | "";
+#if RPC_ENABLE_METHOD_IDS
+        if (obj["method"].is<uint32_t>()) {
+            req.methodId = (int32_t)(obj["method"].as<uint32_t>() & 0x7FFFFFFF);
+        }
+#endif
+        req.params = obj["params"];
+        req.id = obj["id"];
         
         return req.isValid();
     }
     
-    // Execute method
-    RpcResponse executeMethod(RpcRequest& req) {
-        RpcResponse resp;
+    // Execute method and write the complete response object into out.
+    // Pass a null JsonObject for notifications: all writes become no-ops.
+    // Returns the user method that ran (nullptr for built-ins and errors).
+    Method* executeMethod(RpcRequest& req, JsonObject out, RpcFormat format) {
+        uint32_t hash = RpcHash::compute(req.method);
+        
+#if RPC_ENABLE_METRICS
+        stats.requests++;
+#endif
         
         // Built-in introspection methods (memory-efficient)
-        if (req.method == "__rpc.listMethods") {
-            StaticJsonDocument<256> doc;
-            JsonArray arr = doc.to<JsonArray>();
+        if (hash == RpcBuiltin::LIST_METHODS && strcmp(req.method, "__rpc.listMethods") == 0) {
+#if RPC_ENABLE_CACHE
+            if (listMethodsTtl > 0 && !out.isNull() &&
+                cacheLookup(CACHE_LIST_METHODS, 0, listMethodsTtl, format, out, req.id)) {
+                return nullptr;
+            }
+#endif
+            out["jsonrpc"] = "2.0";
+            JsonArray arr = out.createNestedArray("result");
             
             for (uint8_t i = 0; i < MAX_METHODS; i++) {
                 if (methods[i].active) {
-                    arr.add(methods[i].name);
+                    setText(arr.add(), methods[i], methods[i].name);
                 }
             }
             
-            resp.setResult(doc.as<JsonVariant>(), req.id);
-            return resp;
+            out["id"] = req.id;
+            return nullptr;
         }
         
-        if (req.method == "__rpc.version") {
-            StaticJsonDocument<128> doc;
-            doc["toolkit"] = "rpc-arduino-toolkit";
-            doc["version"] = "1.0.0";
-            doc["methodCount"] = methodCount;
+#if RPC_ENABLE_METHOD_IDS
+        // __rpc.methodIds - Numeric IDs to call methods by instead of name
+        if (hash == RpcBuiltin::METHOD_IDS && strcmp(req.method, "__rpc.methodIds") == 0) {
+            out["jsonrpc"] = "2.0";
+            JsonObject result = out.createNestedObject("result");
+            result["generation"] = generation;
+            JsonObject ids = result.createNestedObject("methods");
+            
+            for (uint8_t i = 0; i < MAX_METHODS; i++) {
+                if (!methods[i].active) {
+                    continue;
+                }
+                if (methods[i].flashText) {
+                    ids[(const __FlashStringHelper*)methods[i].name] = methodIdOf(i);
+                } else {
+                    ids[methods[i].name] = methodIdOf(i);
+                }
+            }
             
-            resp.setResult(doc.as<JsonVariant>(), req.id);
-            return resp;
+            out["id"] = req.id;
+            return nullptr;
+        }
+#endif
+        
+        if (hash == RpcBuiltin::VERSION && strcmp(req.method, "__rpc.version") == 0) {
+            out["jsonrpc"] = "2.0";
+            JsonObject result = out.createNestedObject("result");
+            result["toolkit"] = "rpc-arduino-toolkit";
+            result["version"] = "1.0.0";
+            result["methodCount"] = methodCount;
+            out["id"] = req.id;
+            return nullptr;
         }
         
 #if RPC_ENABLE_SCHEMA_SUPPORT
         // __rpc.describe - Get method description and schema availability
-        if (req.method == "__rpc.describe") {
+        if (hash == RpcBuiltin::DESCRIBE && strcmp(req.method, "__rpc.describe") == 0) {
             const char* methodName = req.params["method"] | "";
             
             if (strlen(methodName) == 0) {
-                return RpcError::invalidParams(req.id);
+                RpcError::write(out, RPC_ERROR_INVALID_PARAMS, "Invalid params", req.id);
+                return nullptr;
             }
             
             // Prevent introspection of __rpc.* methods
             if (strncmp(methodName, "__rpc.", 6) == 0) {
-                RpcResponse resp;
-                resp.setError(RPC_ERROR_METHOD_NOT_FOUND, "Cannot describe introspection methods", req.id);
-                return resp;
+                RpcError::write(out, RPC_ERROR_METHOD_NOT_FOUND, "Cannot describe introspection methods", req.id);
+                return nullptr;
             }
             
             // Find method
-            Method* method = nullptr;
-            for (uint8_t i = 0; i < MAX_METHODS; i++) {
-                if (methods[i].active && strcmp(methods[i].name, methodName) == 0) {
-                    method = &methods[i];
-                    break;
-                }
-            }
+            Method* method = findMethod(methodName, RpcHash::compute(methodName));
             
             if (!method) {
-                return RpcError::methodNotFound(methodName, req.id);
+                RpcError::writeMethodNotFound(out, methodName, req.id);
+                return nullptr;
             }
             
             // Check if schema is exposed
             if (!method->exposeSchema) {
-                RpcResponse resp;
-                resp.setError(RPC_ERROR_METHOD_NOT_FOUND, "Method schema not available", req.id);
-                return resp;
+                RpcError::write(out, RPC_ERROR_METHOD_NOT_FOUND, "Method schema not available", req.id);
+                return nullptr;
             }
             
-            StaticJsonDocument<256> doc;
-            doc["name"] = method->name;
-            doc["description"] = method->description;
-            doc["exposeSchema"] = method->exposeSchema;
+            out["jsonrpc"] = "2.0";
+            JsonObject result = out.createNestedObject("result");
+            setText(result["name"], *method, method->name);
+            setText(result["description"], *method, method->description);
+            result["exposeSchema"] = method->exposeSchema;
+            out["id"] = req.id;
+            return nullptr;
+        }
+#endif
+        
+#if RPC_ENABLE_PUBSUB
+        // __rpc.subscribe / __rpc.unsubscribe - Manage topic subscriptions
+        if (hash == RpcBuiltin::SUBSCRIBE && strcmp(req.method, "__rpc.subscribe") == 0) {
+            handleSubscribe(req, out, true);
+            return nullptr;
+        }
+        
+        if (hash == RpcBuiltin::UNSUBSCRIBE && strcmp(req.method, "__rpc.unsubscribe") == 0) {
+            handleSubscribe(req, out, false);
+            return nullptr;
+        }
+#endif
+        
+#if RPC_ENABLE_METRICS
+        // __rpc.stats - Get per-method and server metrics
+        if (hash == RpcBuiltin::STATS && strcmp(req.method, "__rpc.stats") == 0) {
+            const char* only = req.params["method"] | "";
+            
+            out["jsonrpc"] = "2.0";
+            JsonObject result = out.createNestedObject("result");
+            result["requests"] = stats.requests;
+            result["parseErrors"] = stats.parseErrors;
+            result["invalidRequests"] = stats.invalidRequests;
+            result["notFound"] = stats.notFound;
+            result["droppedFrames"] = stats.droppedFrames;
+            
+            JsonObject list = result.createNestedObject("methods");
+            for (uint8_t i = 0; i < MAX_METHODS; i++) {
+                if (!methods[i].active || (only[0] != '\0' && !nameEquals(methods[i], only))) {
+                    continue;
+                }
+                const RpcMethodStats& m = methods[i].stats;
+                JsonObject entry = methods[i].flashText
+                    ? list.createNestedObject((const __FlashStringHelper*)methods[i].name)
+                    : list.createNestedObject(methods[i].name);
+                entry["calls"] = m.calls;
+                entry["errors"] = m.errors;
+                entry["totalUs"] = m.totalMicros;
+                entry["maxUs"] = m.maxMicros;
+                entry["bytesIn"] = m.bytesIn;
+                entry["bytesOut"] = m.bytesOut;
+                entry["cacheHits"] = m.cacheHits;
+            }
             
-            resp.setResult(doc.as<JsonVariant>(), req.id);
-            return resp;
+            out["id"] = req.id;
+            return nullptr;
         }
 #endif
         
         // __rpc.capabilities - Get server capabilities
-        if (req.method == "__rpc.capabilities") {
-            StaticJsonDocument<256> doc;
-            doc["batch"] = RPC_ENABLE_BATCH;
-            doc["introspection"] = true;
-            doc["safeMode"] = RPC_ENABLE_SAFE_MODE;
-            doc["notifications"] = RPC_ENABLE_NOTIFICATIONS;
-            doc["schemaSupport"] = RPC_ENABLE_SCHEMA_SUPPORT;
-            doc["methodCount"] = methodCount;
-            doc["maxMethods"] = MAX_METHODS;
-            
-            resp.setResult(doc.as<JsonVariant>(), req.id);
-            return resp;
+        if (hash == RpcBuiltin::CAPABILITIES && strcmp(req.method, "__rpc.capabilities") == 0) {
+            out["jsonrpc"] = "2.0";
+            JsonObject result = out.createNestedObject("result");
+            result["batch"] = RPC_ENABLE_BATCH;
+            result["introspection"] = true;
+            result["safeMode"] = RPC_ENABLE_SAFE_MODE;
+            result["notifications"] = RPC_ENABLE_NOTIFICATIONS;
+            JsonArray formats = result.createNestedArray("formats");
+            formats.add("json");
+#if RPC_ENABLE_MSGPACK
+            formats.add("msgpack");
+#endif
+            result["schemaSupport"] = RPC_ENABLE_SCHEMA_SUPPORT;
+            result["metrics"] = RPC_ENABLE_METRICS;
+            result["cache"] = RPC_ENABLE_CACHE;
+            result["pubsub"] = RPC_ENABLE_PUBSUB;
+            result["methodIds"] = RPC_ENABLE_METHOD_IDS;
+            result["methodCount"] = methodCount;
+            result["maxMethods"] = MAX_METHODS;
+            out["id"] = req.id;
+            return nullptr;
         }
         
-        // Find method
-        Method* method = nullptr;
-        for (uint8_t i = 0; i < MAX_METHODS; i++) {
-            if (methods[i].active && strcmp(methods[i].name, req.method.c_str()) == 0) {
-                method = &methods[i];
-                break;
+        // Find method (an ID indexes methods[] directly)
+#if RPC_ENABLE_METHOD_IDS
+        Method* method = req.hasMethodId() ? findMethodById(req.methodId) : findMethod(req.method, hash);
+#else
+        Method* method = findMethod(req.method, hash);
+#endif
+        
+        if (!method) {
+#if RPC_ENABLE_METRICS
+            stats.notFound++;
+#endif
+#if RPC_ENABLE_METHOD_IDS
+            if (req.hasMethodId()) {
+                RpcError::write(out, RPC_ERROR_METHOD_NOT_FOUND, "Stale method id", req.id);
+                return nullptr;
             }
+#endif
+            RpcError::writeMethodNotFound(out, req.method, req.id);
+            return nullptr;
         }
         
-        if (!method) {
-            return RpcError::methodNotFound(req.method.c_str(), req.id);
+#if RPC_ENABLE_CACHE
+        if (method->cacheTtl > 0 && !out.isNull() &&
+            cacheLookup(method - methods, RpcHash::ofValue(req.params), method->cacheTtl, format, out, req.id)) {
+#if RPC_ENABLE_METRICS
+            method->stats.cacheHits++;
+#endif
+            return method;
         }
+#else
+        (void)format;
+#endif
         
-        // Execute handler
+#if RPC_ENABLE_METRICS
+        method->stats.calls++;
+        unsigned long startMicros = micros();
+#endif
+        
+        // Execute handler: it writes straight into the "result" slot
+        int code;
         try {
-            JsonVariant result = method->handler(req.params);
-            resp.setResult(result, req.id);
+            out["jsonrpc"] = "2.0";
+            code = method->handler(req.params, out["result"].to<JsonVariant>());
+            out["id"] = req.id;
         } catch (...) {
-            return RpcError::internalError(req.id);
+            code = RPC_ERROR_INTERNAL;
+        }
+        
+        if (code != 0) {
+#if RPC_ENABLE_METRICS
+            method->stats.errors++;
+#endif
+#if RPC_ENABLE_CACHE
+            cachePending.armed = false;
+#endif
+            out.clear();
+            RpcError::write(out, code, RpcError::message(code), req.id);
         }
         
-        return resp;
+#if RPC_ENABLE_METRICS
+        uint32_t elapsed = micros() - startMicros;
+        method->stats.totalMicros += elapsed;
+        if (elapsed > method->stats.maxMicros) {
+            method->stats.maxMicros = elapsed;
+        }
+#endif
+        return method;
     }
     
-public:
-    RpcServer() : methodCount(0) {
-        for (uint8_t i = 0; i < MAX_METHODS; i++) {
-            methods[i].active = false;
-#if RPC_ENABLE_SCHEMA_SUPPORT
-            methods[i].description[0] = '\0';
-            methods[i].exposeSchema = false;
+#if RPC_ENABLE_METRICS
+    // Account request/response sizes to the method that handled them
+    void recordTraffic(Method* method, size_t bytesIn, JsonVariantConst reply, RpcFormat format) {
+        if (!method) {
+            return;
+        }
+        method->stats.bytesIn += bytesIn;
+        if (!reply.isNull()) {
+            method->stats.bytesOut += RpcCodec::measure(reply, format);
+        }
+    }
 #endif
+    
+    // Replace the reply with an internal error when it did not fit in
+    // RPC_JSON_DOC_SIZE; always returns true (a reply must be sent)
+    bool finishResponse(JsonDocument& out, JsonVariantConst id) {
+        if (out.overflowed()) {
+            RPC_LOG("Response too large!");
+            out.clear();
+            RpcError::write(out.to<JsonObject>(), RPC_ERROR_INTERNAL, "Internal error", id);
         }
+        return true;
     }
     
-    /**
-     * Register a method
-     * @param name Method name
-     * @param handler Function to handle the method
-     * @return true if successful
-     */
-    bool addMethod(const char* name, RpcMethodHandler handler) {
-        return addMethod(name, handler, "", false);
+#if RPC_ENABLE_BATCH
+    // Execute a batch array and collect all replies into one response array
+    bool handleBatch(JsonArray batch, JsonDocument& out, RpcFormat format) {
+        if (batch.size() == 0) {
+            RpcError::write(out.to<JsonObject>(), RPC_ERROR_INVALID_REQ, "Invalid Request", JsonVariantConst());
+            return finishResponse(out, JsonVariantConst());
+        }
+        
+        JsonArray replies = out.to<JsonArray>();
+        
+        for (JsonVariant item : batch) {
+            RpcRequest req;
+            
+            if (!parseRequest(item.as<JsonObject>(), req)) {
+#if RPC_ENABLE_METRICS
+                stats.invalidRequests++;
+#endif
+                RpcError::write(replies.createNestedObject(), RPC_ERROR_INVALID_REQ, "Invalid Request", req.id);
+                continue;
+            }
+            
+            // Notifications run but leave no trace in the reply
+            JsonObject reply = req.isNotification() ? JsonObject() : replies.createNestedObject();
+            Method* method = executeMethod(req, reply, format);
+#if RPC_ENABLE_CACHE
+            cacheCommit(out, reply);
+#endif
+#if RPC_ENABLE_METRICS
+            recordTraffic(method, RpcCodec::measure(item, format), reply, format);
+#else
+            (void)method;
+#endif
+        }
+        
+        // Batch made only of notifications: nothing to send back
+        if (replies.size() == 0) {
+            return false;
+        }
+        
+        return finishResponse(out, JsonVariantConst());
     }
+#endif
     
-#if RPC_ENABLE_SCHEMA_SUPPORT
-    /**
-     * Register a method with description and schema exposure
-     * @param name Method name
-     * @param handler Function to handle the method
-     * @param description Method description (max RPC_MAX_DESCRIPTION chars)
-     * @param exposeSchema Whether to expose schema via introspection
-     * @return true if successful
-     */
-    bool addMethod(const char* name, RpcMethodHandler handler, const char* description, bool exposeSchema = false) {
+    // Parse and dispatch one payload, building the reply in out.
+    // Returns false when nothing must be sent back (notifications).
+    // Uses only stack documents: no heap allocation on this path.
+    bool process(const char* json, size_t len, JsonDocument& out, RpcFormat format) {
+        RpcDocument<RPC_JSON_DOC_SIZE> doc;
+        
+        DeserializationError error = RpcCodec::decode(doc, json, len, format);
+        if (error) {
+            return parseFailed(error, out);
+        }
+        
+        return dispatch(doc, out, len, format);
+    }
+    
+#if RPC_ENABLE_IN_SITU
+    // Same as process() but decodes the frame in place: the request
+    // document only holds the tree and its strings point into frame, so
+    // frame must stay untouched until the reply in out has been sent
+    bool processInPlace(char* frame, size_t len, JsonDocument& out, RpcFormat format) {
+        RpcDocument<RPC_IN_SITU_DOC_SIZE> doc;
+        
+        DeserializationError error = RpcCodec::decodeInPlace(doc, frame, len, format);
+        if (error) {
+            return parseFailed(error, out);
+        }
+        
+        return dispatch(doc, out, len, format);
+    }
+#endif
+    
+    bool parseFailed(DeserializationError error, JsonDocument& out) {
+        (void)error;
+        RPC_LOG_F("Parse error: %s", error.c_str());
+#if RPC_ENABLE_METRICS
+        stats.parseErrors++;
+#endif
+        RpcError::write(out.to<JsonObject>(), RPC_ERROR_PARSE, "Parse error", JsonVariantConst());
+        return finishResponse(out, JsonVariantConst());
+    }
+    
+    // Dispatch an already decoded payload (len = encoded size, for metrics)
+    bool dispatch(JsonDocument& doc, JsonDocument& out, size_t len, RpcFormat format) {
+#if !RPC_ENABLE_METRICS
+        (void)len;
+#endif
+        
+#if RPC_ENABLE_BATCH
+        if (doc.is<JsonArray>()) {
+            return handleBatch(doc.as<JsonArray>(), out, format);
+        }
+#endif
+        
+        RpcRequest req;
+        if (!parseRequest(doc.as<JsonObject>(), req)) {
+#if RPC_ENABLE_METRICS
+            stats.invalidRequests++;
+#endif
+            RpcError::write(out.to<JsonObject>(), RPC_ERROR_INVALID_REQ, "Invalid Request", req.id);
+            return finishResponse(out, req.id);
+        }
+        
+        // Notification? (no response needed)
+        if (req.isNotification()) {
+            Method* method = executeMethod(req, JsonObject(), format);
+#if RPC_ENABLE_METRICS
+            recordTraffic(method, len, JsonVariantConst(), format);
+#else
+            (void)method;
+#endif
+            return false;
+        }
+        
+        Method* method = executeMethod(req, out.to<JsonObject>(), format);
+#if RPC_ENABLE_CACHE
+        cacheCommit(out, out.as<JsonVariantConst>());
+#endif
+#if RPC_ENABLE_METRICS
+        recordTraffic(method, len, out, format);
 #else
-    bool addMethod(const char* name, RpcMethodHandler handler, const char* description = "", bool exposeSchema = false) {
+        (void)method;
 #endif
+        return finishResponse(out, req.id);
+    }
+    
+    // Every handler kind is stored as an RpcCheckedHandler (result written
+    // in place, error code returned)
+    static RpcCheckedHandler wrap(RpcMethodHandler handler) {
+        // The returned variant is deep-copied into the response
+        return [handler](JsonVariant params, JsonVariant result) -> int {
+            result.set(handler(params));
+            return 0;
+        };
+    }
+    
+    static RpcCheckedHandler wrap(RpcResultHandler handler) {
+        return [handler](JsonVariant params, JsonVariant result) -> int {
+            handler(params, result);
+            return 0;
+        };
+    }
+    
+    static RpcCheckedHandler wrap(RpcSimpleHandler handler) {
+        return [handler](JsonVariant, JsonVariant result) -> int {
+            result.set(handler());
+            return 0;
+        };
+    }
+    
+    // Common registration path; with flash set, name and description are
+    // PROGMEM strings and only their pointers are kept
+    bool registerMethod(const char* name, RpcCheckedHandler handler, const char* description, bool exposeSchema,
+                        uint32_t cacheTtlMs, bool flash = false) {
         if (methodCount >= MAX_METHODS) {
             RPC_LOG("Max methods reached!");
             return false;
         }
         
-        if (strlen(name) >= RPC_MAX_METHOD_NAME) {
+        if ((flash ? strlen_P(name) : strlen(name)) >= RPC_MAX_METHOD_NAME) {
             RPC_LOG("Method name too long!");
             return false;
         }
@@ -207,21 +815,49 @@ public:
         // Find free slot
         for (uint8_t i = 0; i < MAX_METHODS; i++) {
             if (!methods[i].active) {
-                strncpy(methods[i].name, name, RPC_MAX_METHOD_NAME - 1);
-                methods[i].name[RPC_MAX_METHOD_NAME - 1] = '\0';
+                methods[i].flashText = flash;
+#if RPC_COPY_METHOD_NAMES
+                if (!flash) {
+                    strncpy(methods[i].nameBuf, name, RPC_MAX_METHOD_NAME - 1);
+                    methods[i].nameBuf[RPC_MAX_METHOD_NAME - 1] = '\0';
+                    name = methods[i].nameBuf;
+                }
+#endif
+                methods[i].name = name;
+                methods[i].hash = flash ? RpcHash::compute_P(name) : RpcHash::compute(name);
                 methods[i].handler = handler;
                 methods[i].active = true;
+#if RPC_ENABLE_THREADED
+                methods[i].context = RPC_RUN_ON_WORKER;
+#endif
+#if RPC_ENABLE_METRICS
+                memset(&methods[i].stats, 0, sizeof(methods[i].stats));
+#endif
+#if RPC_ENABLE_CACHE
+                methods[i].cacheTtl = cacheTtlMs;
+                cacheInvalidate(i);
+                cacheInvalidate(CACHE_LIST_METHODS);
+#else
+                (void)cacheTtlMs;
+#endif
 #if RPC_ENABLE_SCHEMA_SUPPORT
-                strncpy(methods[i].description, description, RPC_MAX_DESCRIPTION - 1);
-                methods[i].description[RPC_MAX_DESCRIPTION - 1] = '\0';
+#if RPC_COPY_METHOD_NAMES
+                if (!flash) {
+                    strncpy(methods[i].descriptionBuf, description, RPC_MAX_DESCRIPTION - 1);
+                    methods[i].descriptionBuf[RPC_MAX_DESCRIPTION - 1] = '\0';
+                    description = methods[i].descriptionBuf;
+                }
+#endif
+                methods[i].description = description;
                 methods[i].exposeSchema = exposeSchema;
 #else
                 (void)description;  // Suppress unused parameter warning
                 (void)exposeSchema;
 #endif
                 methodCount++;
+                indexInsert(i);
                 
-                RPC_LOG_F("Method registered: %s", name);
+                RPC_LOG_F("Method registered: %s", flash ? "(flash)" : name);
                 return true;
             }
         }
@@ -229,64 +865,624 @@ public:
         return false;
     }
     
-    /**
-     * Register a simple method (no parameters)
-     */
-    bool addMethod(const char* name, RpcSimpleHandler handler) {
-        return addMethod(name, [handler](JsonObject params) -> JsonVariant {
-            return handler();
-        });
+public:
+    RpcServer() : methodCount(0), transportCount(0), nextTransport(0) {
+#if RPC_ENABLE_METHOD_IDS
+        generation = 0;
+#endif
+#if RPC_ENABLE_METRICS
+        resetStats();
+#endif
+        for (uint8_t i = 0; i < MAX_METHODS; i++) {
+            methods[i].active = false;
+#if RPC_ENABLE_THREADED
+            methods[i].context = RPC_RUN_ON_WORKER;
+#endif
+#if RPC_ENABLE_SCHEMA_SUPPORT
+            methods[i].description = "";
+            methods[i].exposeSchema = false;
+#endif
+        }
+        memset(index, INDEX_EMPTY, sizeof(index));
+#if RPC_ENABLE_PUBSUB
+        for (Topic& topic : topics) {
+            topic.active = false;
+        }
+        for (Subscription& sub : subscriptions) {
+            sub.active = false;
+        }
+        origin = nullptr;
+#endif
+#if RPC_ENABLE_CACHE
+        clearCache();
+        cachePending.armed = false;
+        listMethodsTtl = 0;
+#endif
+    }
+    
+    /**
+     * Register a method
+     * @param name Method name
+     * @param handler Function to handle the method
+     * @return true if successful
+     */
+    bool addMethod(const char* name, RpcMethodHandler handler) {
+        return addMethod(name, handler, "", false);
+    }
+    
+    /**
+     * Register a method with description and schema exposure
+     * @param name Method name
+     * @param handler Function to handle the method
+     * @param description Method description (max RPC_MAX_DESCRIPTION chars)
+     * @param exposeSchema Whether to expose schema via introspection
+     * @param cacheTtlMs Cache results for this long (idempotent methods,
+     *        requires RPC_ENABLE_CACHE; 0 = always run the handler)
+     * @return true if successful
+     */
+    bool addMethod(const char* name, RpcMethodHandler handler, const char* description, bool exposeSchema = false,
+                   uint32_t cacheTtlMs = 0) {
+        return registerMethod(name, wrap(handler), description, exposeSchema, cacheTtlMs);
+    }
+    
+    /**
+     * Register a method that writes its result in place
+     * The handler fills the response document's "result" slot directly,
+     * so no scratch document or deep copy is needed.
+     */
+    bool addMethod(const char* name, RpcResultHandler handler) {
+        return addMethod(name, handler, "", false);
+    }
+    
+    bool addMethod(const char* name, RpcResultHandler handler, const char* description, bool exposeSchema = false,
+                   uint32_t cacheTtlMs = 0) {
+        return registerMethod(name, wrap(handler), description, exposeSchema, cacheTtlMs);
+    }
+    
+    /**
+     * Register a simple method (no parameters)
+     */
+    bool addMethod(const char* name, RpcSimpleHandler handler) {
+        return addMethod(name, handler, "", false);
+    }
+    
+    bool addMethod(const char* name, RpcSimpleHandler handler, const char* description, bool exposeSchema = false,
+                   uint32_t cacheTtlMs = 0) {
+        return registerMethod(name, wrap(handler), description, exposeSchema, cacheTtlMs);
+    }
+    
+    /**
+     * Register a method whose name and description stay in flash
+     * Only pointers are kept in RAM; pass F("name") or FPSTR(progmemArray).
+     * @param description Flash description, nullptr for none
+     */
+    bool addMethod(const __FlashStringHelper* name, RpcMethodHandler handler,
+                   const __FlashStringHelper* description = nullptr, bool exposeSchema = false,
+                   uint32_t cacheTtlMs = 0) {
+        return registerMethod((const char*)name, wrap(handler), (const char*)description, exposeSchema, cacheTtlMs,
+                              true);
+    }
+    
+    bool addMethod(const __FlashStringHelper* name, RpcResultHandler handler,
+                   const __FlashStringHelper* description = nullptr, bool exposeSchema = false,
+                   uint32_t cacheTtlMs = 0) {
+        return registerMethod((const char*)name, wrap(handler), (const char*)description, exposeSchema, cacheTtlMs,
+                              true);
+    }
+    
+    bool addMethod(const __FlashStringHelper* name, RpcSimpleHandler handler,
+                   const __FlashStringHelper* description = nullptr, bool exposeSchema = false,
+                   uint32_t cacheTtlMs = 0) {
+        return registerMethod((const char*)name, wrap(handler), (const char*)description, exposeSchema, cacheTtlMs,
+                              true);
+    }
+    
+    /**
+     * Register a typed method: params are extracted, type-checked and
+     * converted to the function's arguments; its return value becomes the
+     * result. Missing or mistyped arguments reply -32602 Invalid params.
+     * @param name Method name
+     * @param fn Function or lambda matching Sig
+     * @param argNames One name per argument (string literals) for named
+     *        params; omit to accept positional (array) params only
+     * 
+     * Example: rpc.addMethod<float(int, float)>("scale", fn, "pin", "gain");
+     */
+    template<typename Sig, typename Fn, typename... Names>
+    bool addMethod(const char* name, Fn fn, Names... argNames) {
+        static_assert(sizeof...(Names) == 0 || sizeof...(Names) == RpcTypedMethod<Sig>::ARITY,
+                      "Give one name per argument, or none for positional params");
+        const char* names[] = {argNames..., nullptr};
+        return registerMethod(name, RpcTypedMethod<Sig>(names, sizeof...(Names)).bind(fn), "", false, 0);
     }
     
     /**
      * Remove a method
      */
     bool removeMethod(const char* name) {
-        for (uint8_t i = 0; i < MAX_METHODS; i++) {
-            if (methods[i].active && strcmp(methods[i].name, name) == 0) {
-                methods[i].active = false;
-                methodCount--;
-                RPC_LOG_F("Method removed: %s", name);
-                return true;
-            }
+        Method* method = findMethod(name, RpcHash::compute(name));
+        if (!method) {
+            return false;
+        }
+        
+        method->active = false;
+        methodCount--;
+        rebuildIndex();
+#if RPC_ENABLE_METHOD_IDS
+        generation++;
+#endif
+#if RPC_ENABLE_CACHE
+        cacheInvalidate(method - methods);
+        cacheInvalidate(CACHE_LIST_METHODS);
+#endif
+        RPC_LOG_F("Method removed: %s", name);
+        return true;
+    }
+    
+    /**
+     * Answer every oversize frame the transport dropped since the last call
+     * with -32600 (id null), so the peer is not left waiting for a reply
+     * Called by serve() and handleRequest(transport), and by RpcWorker.
+     * Request/response transports (HTTP) have already answered it.
+     */
+    void replyDropped(RpcTransport& transport) {
+        uint32_t count = transport.takeDroppedFrames();
+#if RPC_ENABLE_METRICS
+        stats.droppedFrames += count;
+#endif
+        if (count == 0 || !transport.canPush()) {
+            return;
+        }
+        
+        RpcDocument<256> out;
+        RpcError::write(out.to<JsonObject>(), RPC_ERROR_INVALID_REQ, "Request too large", JsonVariantConst());
+        while (count-- > 0) {
+            transport.writeDocument(out);
         }
-        return false;
     }
     
     /**
      * Handle request from transport
      */
     String handleRequest(RpcTransport& transport) {
+#if RPC_ENABLE_PUBSUB
+        OriginScope scope(origin, &transport);
+#endif
+#if RPC_ENABLE_IN_SITU
+        if (transport.hasFrameBuffer()) {
+            size_t len;
+            char* frame = transport.peekFrame(len);
+            replyDropped(transport);
+            if (!frame) {
+                return "";
+            }
+            
+            // Encode before releasing: the reply may reference the frame (id)
+            RpcDocument<RPC_JSON_DOC_SIZE> out;
+            String output;
+            if (processInPlace(frame, len, out, transport.getFormat())) {
+                RpcCodec::encode(out, output, transport.getFormat());
+            }
+            transport.releaseFrame();
+            return output;
+        }
+#endif
         String json = transport.read();
+        replyDropped(transport);
         if (json.isEmpty()) {
             return "";
         }
         
-        return handleRequest(json);
+        return handleRequest(json, transport.getFormat());
     }
     
     /**
-     * Handle request from JSON string
+     * Handle one request from transport and stream the reply back into it
+     * The response document is serialized directly into the transport
+     * (see RpcTransport::writeDocument): no response String is built.
+     * @return true if a request was handled
      */
-    String handleRequest(const String& json) {
-        StaticJsonDocument<RPC_JSON_DOC_SIZE> doc;
-        RpcRequest req;
+    bool serve(RpcTransport& transport) {
+#if RPC_ENABLE_PUBSUB
+        OriginScope scope(origin, &transport);
+#endif
+#if RPC_ENABLE_IN_SITU
+        if (transport.hasFrameBuffer()) {
+            size_t len;
+            char* frame = transport.peekFrame(len);
+            replyDropped(transport);
+            if (!frame) {
+                return false;
+            }
+            
+            RpcDocument<RPC_JSON_DOC_SIZE> out;
+            if (processInPlace(frame, len, out, transport.getFormat())) {
+                transport.writeDocument(out);
+            }
+            transport.releaseFrame();  // Request strings were referenced until now
+            return true;
+        }
+#endif
+        String json = transport.read();
+        replyDropped(transport);
+        if (json.isEmpty()) {
+            return false;
+        }
         
-        // Parse request
-        if (!parseRequest(json, req, doc)) {
-            RpcResponse resp = RpcError::parseError(nullptr);
-            return resp.toString();
+        RpcDocument<RPC_JSON_DOC_SIZE> out;
+        if (process(json.c_str(), json.length(), out, transport.getFormat())) {
+            transport.writeDocument(out);
         }
+        return true;
+    }
+    
+    /**
+     * Handle request from JSON string
+     * Accepts a single request object or, with RPC_ENABLE_BATCH, a batch array
+     * @param format Wire format of both request and response
+     */
+    String handleRequest(const String& json, RpcFormat format = RPC_FORMAT_JSON) {
+        RpcDocument<RPC_JSON_DOC_SIZE> out;
         
-        // Notification? (no response needed)
-        if (req.isNotification()) {
-            executeMethod(req);
+        if (!process(json.c_str(), json.length(), out, format)) {
             return "";
         }
         
-        // Execute and return response
-        RpcResponse resp = executeMethod(req);
-        return resp.toString();
+        String output;
+        RpcCodec::encode(out, output, format);
+        return output;
+    }
+    
+    /**
+     * Handle a request that has already been decoded into a document
+     * Used when parsing happens elsewhere (e.g. on the RpcWorker task).
+     * @param request Request object or batch array
+     * @param out Document receiving the reply
+     * @param format Wire format the reply will be encoded in
+     * @return false when nothing must be sent back (notifications)
+     */
+    bool handleDocument(JsonDocument& request, JsonDocument& out, RpcFormat format = RPC_FORMAT_JSON) {
+#if RPC_ENABLE_METRICS
+        size_t len = RpcCodec::measure(request, format);
+#else
+        size_t len = 0;
+#endif
+        return dispatch(request, out, len, format);
+    }
+    
+    /**
+     * Handle request from a caller-supplied buffer (zero heap allocation)
+     * @param in Request JSON (need not be null-terminated)
+     * @param len Length of the request in bytes
+     * @param out Buffer receiving the null-terminated response
+     * @param outCap Capacity of out in bytes
+     * @param format Wire format of both request and response
+     * @return Length of the response, 0 if there is nothing to send
+     *         (notification) or the response does not fit in out
+     */
+    size_t handleRequest(const char* in, size_t len, char* out, size_t outCap, RpcFormat format = RPC_FORMAT_JSON) {
+        RpcDocument<RPC_JSON_DOC_SIZE> reply;
+        
+        if (outCap > 0) {
+            out[0] = '\0';
+        }
+        
+        if (!process(in, len, reply, format)) {
+            return 0;
+        }
+        
+        if (RpcCodec::measure(reply, format) >= outCap) {
+            RPC_LOG("Output buffer too small!");
+            return 0;
+        }
+        
+        return RpcCodec::encode(reply, out, outCap, format);
+    }
+    
+#if RPC_ENABLE_THREADED
+    /**
+     * Choose where a method's handler runs in threaded mode
+     * Set this before RpcWorker::begin(); the table is read concurrently.
+     */
+    bool setMethodContext(const char* name, RpcExecContext context) {
+        Method* method = findMethod(name, RpcHash::compute(name));
+        if (!method) {
+            return false;
+        }
+        method->context = context;
+        return true;
+    }
+    
+    /**
+     * Execution context of a method (RPC_RUN_ON_WORKER if unknown)
+     */
+    RpcExecContext getMethodContext(const char* name) {
+        Method* method = findMethod(name, RpcHash::compute(name));
+        return method ? method->context : RPC_RUN_ON_WORKER;
+    }
+    
+#if RPC_ENABLE_METHOD_IDS
+    RpcExecContext getMethodContext(uint32_t id) {
+        Method* method = findMethodById(id);
+        return method ? method->context : RPC_RUN_ON_WORKER;
+    }
+#endif
+#endif
+    
+#if RPC_ENABLE_CACHE
+    /**
+     * Cache results of an idempotent method for ttlMs milliseconds
+     * Also accepts "__rpc.listMethods" (invalidated on add/remove).
+     * @param ttlMs Result lifetime, 0 disables caching for the method
+     * @return false if the method is not registered
+     */
+    bool setMethodCache(const char* name, uint32_t ttlMs) {
+        uint32_t hash = RpcHash::compute(name);
+        if (hash == RpcBuiltin::LIST_METHODS && strcmp(name, "__rpc.listMethods") == 0) {
+            listMethodsTtl = ttlMs;
+            cacheInvalidate(CACHE_LIST_METHODS);
+            return true;
+        }
+        
+        Method* method = findMethod(name, hash);
+        if (!method) {
+            return false;
+        }
+        method->cacheTtl = ttlMs;
+        cacheInvalidate(method - methods);
+        return true;
+    }
+    
+    /**
+     * Drop all cached results of a method (call when its state changes)
+     */
+    void invalidateCache(const char* name) {
+        uint32_t hash = RpcHash::compute(name);
+        if (hash == RpcBuiltin::LIST_METHODS && strcmp(name, "__rpc.listMethods") == 0) {
+            cacheInvalidate(CACHE_LIST_METHODS);
+            return;
+        }
+        
+        Method* method = findMethod(name, hash);
+        if (method) {
+            cacheInvalidate(method - methods);
+        }
+    }
+    
+    /**
+     * Drop every cached result
+     */
+    void clearCache() {
+        for (CacheEntry& entry : cache) {
+            entry.slot = CACHE_FREE;
+        }
+    }
+#endif
+    
+    /**
+     * Attach a transport to be served by poll()
+     * @return false if already attached or RPC_MAX_TRANSPORTS is reached
+     */
+    bool attach(RpcTransport& transport) {
+        for (uint8_t i = 0; i < transportCount; i++) {
+            if (transports[i] == &transport) {
+                return false;
+            }
+        }
+        
+        if (transportCount >= RPC_MAX_TRANSPORTS) {
+            RPC_LOG("Transport table full");
+            return false;
+        }
+        
+        transports[transportCount++] = &transport;
+        return true;
+    }
+    
+    /**
+     * Detach a transport previously passed to attach()
+     */
+    bool detach(RpcTransport& transport) {
+        for (uint8_t i = 0; i < transportCount; i++) {
+            if (transports[i] == &transport) {
+                for (uint8_t j = i + 1; j < transportCount; j++) {
+                    transports[j - 1] = transports[j];
+                }
+                transportCount--;
+                if (nextTransport >= transportCount) {
+                    nextTransport = 0;
+                }
+#if RPC_ENABLE_PUBSUB
+                dropSubscriptions(transport);
+#endif
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Serve all attached transports without blocking (call from loop())
+     * Transports are visited round-robin; each ready request is handled and
+     * its reply written back to the transport it came from. Stops after
+     * maxRequests requests, when budgetMicros has elapsed (a request already
+     * started always completes) or when no transport has anything ready.
+     * With RPC_ENABLE_PUBSUB, due notifications are flushed afterwards.
+     * @return Number of requests handled
+     */
+    uint8_t poll(uint32_t budgetMicros, uint8_t maxRequests = RPC_POLL_MAX_REQUESTS) {
+        unsigned long start = micros();
+        uint8_t handled = 0;
+        uint8_t idle = 0;  // Consecutive transports with nothing ready
+        
+        while (transportCount > 0 && handled < maxRequests && idle < transportCount) {
+            RpcTransport* transport = transports[nextTransport];
+            nextTransport = (nextTransport + 1) % transportCount;
+            
+            if (serve(*transport)) {
+                handled++;
+                idle = 0;
+            } else {
+                idle++;
+            }
+            
+            if ((uint32_t)(micros() - start) >= budgetMicros) {
+                break;
+            }
+        }
+        
+#if RPC_ENABLE_PUBSUB
+        flushSubscriptions();
+#endif
+        return handled;
+    }
+    
+#if RPC_ENABLE_PUBSUB
+    /**
+     * Register a topic clients can subscribe to with __rpc.subscribe
+     * Notifications are sent as {"jsonrpc":"2.0","method":name,"params":value}.
+     * @param name Topic name (max RPC_MAX_METHOD_NAME - 1 chars)
+     * @param producer Writes the topic's current value when a notification
+     *        is due (called at most once per topic per flush)
+     * @return false if the topic table is full or the name is taken
+     */
+    bool addTopic(const char* name, RpcTopicHandler producer) {
+        if (strlen(name) >= RPC_MAX_METHOD_NAME || findTopic(name)) {
+            return false;
+        }
+        
+        for (Topic& topic : topics) {
+            if (!topic.active) {
+                strncpy(topic.name, name, RPC_MAX_METHOD_NAME - 1);
+                topic.name[RPC_MAX_METHOD_NAME - 1] = '\0';
+                topic.hash = RpcHash::compute(topic.name);
+                topic.producer = producer;
+                topic.active = true;
+                return true;
+            }
+        }
+        
+        RPC_LOG("Topic table full");
+        return false;
+    }
+    
+    /**
+     * Remove a topic and all its subscriptions
+     */
+    bool removeTopic(const char* name) {
+        Topic* topic = findTopic(name);
+        if (!topic) {
+            return false;
+        }
+        
+        topic->active = false;
+        for (Subscription& sub : subscriptions) {
+            if (sub.topic == topic - topics) {
+                sub.active = false;
+            }
+        }
+        return true;
+    }
+    
+    /**
+     * Signal that a topic's value changed
+     * Cheap: the value is only produced when a notification is sent, so
+     * call it as often as the value changes.
+     */
+    void publish(const char* name) {
+        Topic* topic = findTopic(name);
+        if (!topic) {
+            return;
+        }
+        
+        for (Subscription& sub : subscriptions) {
+            if (sub.active && sub.topic == topic - topics) {
+                sub.dirty = true;
+            }
+        }
+    }
+    
+    /**
+     * Send every notification that is due (published and past its interval)
+     * Called by poll(); call it from loop() when serving with serve().
+     * A failed write keeps the subscription dirty, so the latest value is
+     * sent on a later flush.
+     * @return Number of notifications sent
+     */
+    uint8_t flushSubscriptions() {
+        unsigned long now = millis();
+        uint8_t sent = 0;
+        
+        for (uint8_t t = 0; t < RPC_MAX_TOPICS; t++) {
+            if (!topics[t].active) {
+                continue;
+            }
+            
+            // Built on first use, then shared by every due subscriber
+            RpcDocument<RPC_JSON_DOC_SIZE> doc;
+            bool built = false;
+            
+            for (Subscription& sub : subscriptions) {
+                if (!sub.active || sub.topic != t || !sub.dirty || now - sub.lastSent < sub.interval) {
+                    continue;
+                }
+                
+                if (!built) {
+                    doc["jsonrpc"] = "2.0";
+                    doc["method"] = topics[t].name;
+                    topics[t].producer(doc["params"].to<JsonVariant>());
+                    built = true;
+                }
+                
+                if (doc.overflowed()) {
+                    RPC_LOG_F("Topic value too large: %s", topics[t].name);
+                    sub.dirty = false;
+                    continue;
+                }
+                
+                if (sub.transport->writeDocument(doc)) {
+                    sub.dirty = false;
+                    sub.lastSent = now;
+                    sent++;
+                }
+            }
+        }
+        
+        return sent;
+    }
+    
+    /**
+     * Drop every subscription made over a transport (e.g. when its client
+     * disconnects); detach() does this automatically
+     */
+    void dropSubscriptions(RpcTransport& transport) {
+        for (Subscription& sub : subscriptions) {
+            if (sub.transport == &transport) {
+                sub.active = false;
+            }
+        }
+    }
+    
+    /**
+     * Number of active subscriptions to a topic
+     */
+    uint8_t getSubscriberCount(const char* name) {
+        Topic* topic = findTopic(name);
+        uint8_t count = 0;
+        for (Subscription& sub : subscriptions) {
+            if (topic && sub.active && sub.topic == topic - topics) {
+                count++;
+            }
+        }
+        return count;
+    }
+#endif
+    
+    /**
+     * Get number of attached transports
+     */
+    uint8_t getTransportCount() const {
+        return transportCount;
     }
     
     /**
@@ -295,6 +1491,52 @@ public:
     uint8_t getMethodCount() const {
         return methodCount;
     }
+    
+#if RPC_ENABLE_METHOD_IDS
+    /**
+     * Numeric ID a client may send as "method" instead of the name
+     * Valid until a method is removed (see getMethodGeneration()).
+     * @return -1 if the method is not registered
+     */
+    int32_t getMethodId(const char* name) {
+        Method* method = findMethod(name, RpcHash::compute(name));
+        return method ? (int32_t)methodIdOf(method - methods) : -1;
+    }
+    
+    /**
+     * Method table generation, part of every method ID
+     */
+    uint16_t getMethodGeneration() const {
+        return generation;
+    }
+#endif
+    
+#if RPC_ENABLE_METRICS
+    /**
+     * Server-wide counters (parse failures, dropped frames, ...)
+     */
+    const RpcServerStats& getStats() const {
+        return stats;
+    }
+    
+    /**
+     * Counters of one method, nullptr if not registered
+     */
+    const RpcMethodStats* getMethodStats(const char* name) {
+        Method* method = findMethod(name, RpcHash::compute(name));
+        return method ? &method->stats : nullptr;
+    }
+    
+    /**
+     * Zero all server and method counters
+     */
+    void resetStats() {
+        memset(&stats, 0, sizeof(stats));
+        for (uint8_t i = 0; i < MAX_METHODS; i++) {
+            memset(&methods[i].stats, 0, sizeof(methods[i].stats));
+        }
+    }
+#endif
 };
 
 #endif // RPC_SERVER_H
@@ -0,0 +1,116 @@
+/**
+ * RPC Arduino Toolkit - Lock-Free SPSC Queue
+ * 
+ * Fixed-capacity single-producer / single-consumer ring of pre-sized
+ * slots. The producer fills a slot in place (reserve/commit) and the
+ * consumer reads it in place (front/pop), so nothing is copied or
+ * allocated. Only std::atomic is used: the same code runs between
+ * FreeRTOS tasks on the two ESP32 cores and between std::threads on a
+ * host machine.
+ */
+
+#ifndef RPC_SPSC_QUEUE_H
+#define RPC_SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+template<typename T, uint8_t CAPACITY>
+class RpcSpscQueue {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "RpcSpscQueue capacity must be a power of two");
+    
+private:
+    static const uint32_t MASK = CAPACITY - 1;
+    
+    T slots[CAPACITY];
+    std::atomic<uint32_t> head;  // Next slot to read (written by consumer only)
+    std::atomic<uint32_t> tail;  // Next slot to write (written by producer only)
+    
+public:
+    RpcSpscQueue() : head(0), tail(0) {}
+    
+    // ------------------------------------------------------------------------
+    // Producer side
+    // ------------------------------------------------------------------------
+    
+    /**
+     * Free slot to fill in place, nullptr if the queue is full
+     * The slot becomes visible to the consumer on commit().
+     */
+    T* reserve() {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            return nullptr;
+        }
+        return &slots[t & MASK];
+    }
+    
+    /**
+     * Publish the slot returned by reserve()
+     */
+    void commit() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    
+    bool push(const T& item) {
+        T* slot = reserve();
+        if (!slot) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Consumer side
+    // ------------------------------------------------------------------------
+    
+    /**
+     * Oldest published slot, nullptr if the queue is empty
+     * The slot stays owned by the consumer until pop().
+     */
+    T* front() {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[h & MASK];
+    }
+    
+    /**
+     * Hand the slot returned by front() back to the producer
+     */
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    
+    bool pop(T& item) {
+        T* slot = front();
+        if (!slot) {
+            return false;
+        }
+        item = *slot;
+        pop();
+        return true;
+    }
+    
+    // ------------------------------------------------------------------------
+    // Either side (a snapshot: the other side may change it concurrently)
+    // ------------------------------------------------------------------------
+    
+    uint8_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    
+    bool empty() const {
+        return size() == 0;
+    }
+    
+    static constexpr uint8_t capacity() {
+        return CAPACITY;
+    }
+};
+
+#endif // RPC_SPSC_QUEUE_H
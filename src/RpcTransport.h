@@ -9,6 +9,7 @@
 
 #include <Arduino.h>
 #include "RpcConfig.h"
+#include "RpcCodec.h"
 
 // ============================================================================
 // RPC Transport Base Class
@@ -31,6 +32,102 @@ public:
      */
     virtual bool write(const String& data) = 0;
     
+    /**
+     * Read one frame into a caller-supplied buffer
+     * Default implementation goes through read(); transports override it
+     * to avoid the intermediate String.
+     * A frame that does not fit in buf is consumed and counted as dropped
+     * (takeDroppedFrames()), never truncated.
+     * @param buf Destination buffer (null-terminated on return)
+     * @param cap Capacity of buf in bytes
+     * @return Frame length, 0 if no data or the frame was dropped
+     */
+    virtual size_t readFrame(char* buf, size_t cap) {
+        if (cap == 0) {
+            return 0;
+        }
+        
+        String data = read();
+        if (data.length() >= cap) {
+            RPC_LOG("Frame too large for buffer, discarding");
+            droppedReads++;
+            return 0;
+        }
+        memcpy(buf, data.c_str(), data.length() + 1);
+        return data.length();
+    }
+    
+    /**
+     * Write one frame from a caller-supplied buffer
+     * Default implementation goes through write(const String&).
+     * @param data Frame bytes
+     * @param len Frame length
+     * @return true if successful
+     */
+    virtual bool writeFrame(const char* data, size_t len) {
+        String frame;
+        frame.reserve(len);
+        RpcCodec::appendBytes(frame, (const uint8_t*)data, len);
+        return write(frame);
+    }
+    
+    /**
+     * Write one message by serializing doc straight into the transport
+     * Default implementation encodes into a String and calls write();
+     * transports override it to stream without materializing the message.
+     * @param doc Message to send (encoded with getFormat())
+     * @return true if successful
+     */
+    virtual bool writeDocument(JsonVariantConst doc) {
+        String data;
+        RpcCodec::encode(doc, data, format);
+        return write(data);
+    }
+    
+    /**
+     * Whether peekFrame() is supported (the transport owns a receive buffer)
+     */
+    virtual bool hasFrameBuffer() const {
+        return false;
+    }
+    
+    /**
+     * Borrow the receive buffer holding the next complete frame
+     * Used for in-situ parsing (RPC_ENABLE_IN_SITU): the frame is decoded
+     * in place, so it is modified and must stay untouched until
+     * releaseFrame() is called once the reply has been sent.
+     * @param len Receives the frame length
+     * @return Frame start, nullptr if no frame is ready
+     */
+    virtual char* peekFrame(size_t& len) {
+        len = 0;
+        return nullptr;
+    }
+    
+    /**
+     * Hand back the buffer returned by peekFrame()
+     */
+    virtual void releaseFrame() {}
+    
+    /**
+     * Oversize frames dropped since the last call (consumed by the server,
+     * which answers each one with -32600 on transports that canPush())
+     */
+    virtual uint32_t takeDroppedFrames() {
+        uint32_t count = droppedReads;
+        droppedReads = 0;
+        return count;
+    }
+    
+    /**
+     * Whether write() may be called without a pending request, i.e. the
+     * server can push notifications (false for request/response transports
+     * such as HTTP)
+     */
+    virtual bool canPush() const {
+        return true;
+    }
+    
     /**
      * Check if transport is available/connected
      * @return true if ready
@@ -45,8 +142,22 @@ public:
         timeout = ms;
     }
     
+    /**
+     * Select the wire format carried by this transport
+     * Both ends must agree (see "formats" in __rpc.capabilities).
+     */
+    virtual void setFormat(RpcFormat f) {
+        format = f;
+    }
+    
+    RpcFormat getFormat() const {
+        return format;
+    }
+    
 protected:
     unsigned long timeout = RPC_DEFAULT_TIMEOUT;
+    RpcFormat format = RPC_FORMAT_JSON;
+    uint32_t droppedReads = 0;  // Frames the default readFrame() could not fit
 };
 
 #endif // RPC_TRANSPORT_H
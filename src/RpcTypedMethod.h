@@ -0,0 +1,230 @@
+/**
+ * RPC Arduino Toolkit - Typed Method Registration
+ * 
+ * Builds the handler behind RpcServer::addMethod<Ret(Args...)>():
+ * argument names are hashed once at registration, params (positional
+ * array or named object) are collected in a single pass, every argument
+ * is type-checked by its RpcArg converter and the return value is
+ * written straight into the result. A missing, mistyped, unknown or
+ * repeated argument produces -32602 Invalid params without reaching the
+ * function.
+ * 
+ * Usage:
+ *   rpc.addMethod<int(int, int)>("add", [](int a, int b) {
+ *       return a + b;
+ *   }, "a", "b");
+ *   // {"params":{"a":5,"b":3}} or {"params":[5,3]} -> 8
+ */
+
+#ifndef RPC_TYPED_METHOD_H
+#define RPC_TYPED_METHOD_H
+
+#include <type_traits>
+#include "RpcTypes.h"
+
+// ============================================================================
+// Argument Converters
+// ============================================================================
+
+// Default: anything ArduinoJson converts (integers are range-checked)
+template<typename T>
+struct RpcArg {
+    static bool is(JsonVariant v) {
+        return v.is<T>();
+    }
+    
+    static T get(JsonVariant v) {
+        return v.as<T>();
+    }
+};
+
+template<>
+struct RpcArg<String> {
+    static bool is(JsonVariant v) {
+        return v.is<const char*>();
+    }
+    
+    static String get(JsonVariant v) {
+        return v.as<String>();
+    }
+};
+
+// Numbers of either kind are accepted for floating-point arguments,
+// including integers beyond the range of long (64-bit JsonInteger/JsonUInt)
+inline bool rpcIsNumber(JsonVariant v) {
+    return v.is<double>() || v.is<JsonInteger>() || v.is<JsonUInt>();
+}
+
+template<>
+struct RpcArg<float> {
+    static bool is(JsonVariant v) {
+        return rpcIsNumber(v);
+    }
+    
+    static float get(JsonVariant v) {
+        return v.as<float>();
+    }
+};
+
+template<>
+struct RpcArg<double> {
+    static bool is(JsonVariant v) {
+        return rpcIsNumber(v);
+    }
+    
+    static double get(JsonVariant v) {
+        return v.as<double>();
+    }
+};
+
+// Raw access: any value (including null) is accepted
+template<>
+struct RpcArg<JsonVariant> {
+    static bool is(JsonVariant) {
+        return true;
+    }
+    
+    static JsonVariant get(JsonVariant v) {
+        return v;
+    }
+};
+
+// ============================================================================
+// Return Value
+// ============================================================================
+
+template<typename Ret>
+struct RpcReturn {
+    template<typename Fn, typename... A>
+    static void invoke(JsonVariant result, Fn& fn, A... args) {
+        result.set(fn(args...));
+    }
+};
+
+// void functions reply with a null result
+template<>
+struct RpcReturn<void> {
+    template<typename Fn, typename... A>
+    static void invoke(JsonVariant, Fn& fn, A... args) {
+        fn(args...);
+    }
+};
+
+// ============================================================================
+// Typed Method
+// ============================================================================
+
+template<size_t... I>
+struct RpcIndices {};
+
+template<size_t N, size_t... I>
+struct RpcMakeIndices : RpcMakeIndices<N - 1, N - 1, I...> {};
+
+template<size_t... I>
+struct RpcMakeIndices<0, I...> {
+    typedef RpcIndices<I...> type;
+};
+
+template<typename Sig>
+class RpcTypedMethod;
+
+template<typename Ret, typename... Args>
+class RpcTypedMethod<Ret(Args...)> {
+public:
+    static const size_t ARITY = sizeof...(Args);
+    
+private:
+    static const size_t SLOTS = ARITY > 0 ? ARITY : 1;
+    typedef typename RpcMakeIndices<ARITY>::type Indices;
+    
+    const char* names[SLOTS];  // Must outlive the server (string literals)
+    uint32_t hashes[SLOTS];
+    bool named;
+    
+    // Gather the arguments into slots[] with one pass over params
+    bool collect(JsonVariant params, JsonVariant* slots) const {
+        if (ARITY == 0) {
+            return params.isNull() || params.size() == 0;
+        }
+        
+        if (params.is<JsonArray>()) {
+            JsonArray array = params.as<JsonArray>();
+            if (array.size() != ARITY) {
+                return false;
+            }
+            size_t i = 0;
+            for (JsonVariant value : array) {
+                slots[i++] = value;
+            }
+            return true;
+        }
+        
+        if (!named || !params.is<JsonObject>()) {
+            return false;
+        }
+        
+        bool seen[SLOTS] = {};
+        size_t found = 0;
+        for (JsonPair member : params.as<JsonObject>()) {
+            const char* key = member.key().c_str();
+            uint32_t hash = RpcHash::compute(key);
+            size_t i = 0;
+            while (i < ARITY && !(hashes[i] == hash && strcmp(names[i], key) == 0)) {
+                i++;
+            }
+            if (i == ARITY || seen[i]) {
+                return false;  // Unknown or repeated member
+            }
+            slots[i] = member.value();
+            seen[i] = true;
+            found++;
+        }
+        return found == ARITY;
+    }
+    
+    template<size_t... I>
+    static bool check(JsonVariant* slots, RpcIndices<I...>) {
+        bool ok[] = {true, RpcArg<typename std::decay<Args>::type>::is(slots[I])...};
+        for (bool valid : ok) {
+            if (!valid) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    template<typename Fn, size_t... I>
+    static void call(Fn& fn, JsonVariant* slots, JsonVariant result, RpcIndices<I...>) {
+        RpcReturn<Ret>::invoke(result, fn, RpcArg<typename std::decay<Args>::type>::get(slots[I])...);
+    }
+    
+public:
+    /**
+     * @param argNames ARITY names for named params, or count 0 to accept
+     *        positional (array) params only
+     */
+    RpcTypedMethod(const char* const* argNames, size_t count) : named(count == ARITY && ARITY > 0) {
+        for (size_t i = 0; i < SLOTS; i++) {
+            names[i] = named ? argNames[i] : "";
+            hashes[i] = RpcHash::compute(names[i]);
+        }
+    }
+    
+    /**
+     * Wrap fn into a handler that extracts and checks its arguments
+     */
+    template<typename Fn>
+    RpcCheckedHandler bind(Fn fn) const {
+        RpcTypedMethod method = *this;
+        return [method, fn](JsonVariant params, JsonVariant result) mutable -> int {
+            JsonVariant slots[SLOTS];
+            if (!method.collect(params, slots) || !check(slots, Indices())) {
+                return RPC_ERROR_INVALID_PARAMS;
+            }
+            call(fn, slots, result, Indices());
+            return 0;
+        };
+    }
+};
+
+#endif // RPC_TYPED_METHOD_H
@@ -8,6 +8,8 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "RpcConfig.h"
+#include "RpcCodec.h"
+#include "RpcMemoryPool.h"
 
 // ============================================================================
 // Forward Declarations
@@ -22,31 +24,201 @@ class RpcResponse;
 // ============================================================================
 
 // Method handler function signature
-// Takes JsonObject parameters and returns JsonVariant result
-typedef std::function<JsonVariant(JsonObject)> RpcMethodHandler;
+// Takes the params and returns JsonVariant result. Handlers may declare the
+// parameter as JsonObject (named params) or JsonArray (positional params);
+// the other shape then arrives as a null object/array.
+typedef std::function<JsonVariant(JsonVariant)> RpcMethodHandler;
 
 // Simple handler without parameters
 typedef std::function<JsonVariant(void)> RpcSimpleHandler;
 
+// In-place handler: writes its result into the response document
+// (params may be taken as JsonObject, JsonArray or their Const forms)
+typedef std::function<void(JsonVariant params, JsonVariant result)> RpcResultHandler;
+
+// Form every handler is stored in by RpcServer: writes the result in place
+// and returns 0, or returns a JSON-RPC error code (e.g. -32602)
+typedef std::function<int(JsonVariant params, JsonVariant result)> RpcCheckedHandler;
+
+#if RPC_ENABLE_PUBSUB
+// Topic producer: writes the topic's current value when a notification is due
+typedef std::function<void(JsonVariant value)> RpcTopicHandler;
+#endif
+
+// ============================================================================
+// Method Name Hashing
+// ============================================================================
+
+class RpcHash {
+public:
+    /**
+     * FNV-1a (32-bit) of a null-terminated string, usable at compile time
+     */
+    static constexpr uint32_t fnv1a(const char* s, uint32_t h = 2166136261UL) {
+        return *s ? fnv1a(s + 1, (uint32_t)((h ^ (uint8_t)*s) * 16777619UL)) : h;
+    }
+    
+    /**
+     * Same hash computed iteratively (runtime, no recursion)
+     */
+    static uint32_t compute(const char* s) {
+        uint32_t h = 2166136261UL;
+        while (*s) {
+            h = (uint32_t)((h ^ (uint8_t)*s++) * 16777619UL);
+        }
+        return h;
+    }
+    
+    /**
+     * Same hash of a string in flash (PROGMEM)
+     */
+    static uint32_t compute_P(const char* s) {
+        uint32_t h = 2166136261UL;
+        uint8_t c;
+        while ((c = pgm_read_byte(s++)) != 0) {
+            h = (uint32_t)((h ^ c) * 16777619UL);
+        }
+        return h;
+    }
+    
+    /**
+     * Smallest power of two >= n (open-addressed table sizing)
+     */
+    static constexpr uint16_t tableSize(uint16_t n, uint16_t size = 1) {
+        return size >= n ? size : tableSize(n, (uint16_t)(size << 1));
+    }
+    
+    /**
+     * Hash of a JSON value that ignores object member order, so
+     * {"a":1,"b":2} and {"b":2,"a":1} hash alike (response cache keys)
+     */
+    static uint32_t ofValue(JsonVariantConst value) {
+        if (value.is<JsonObjectConst>()) {
+            uint32_t h = 0;
+            for (JsonPairConst member : value.as<JsonObjectConst>()) {
+                h += mix(compute(member.key().c_str()), ofValue(member.value()));
+            }
+            return mix(h, '{');
+        }
+        
+        if (value.is<JsonArrayConst>()) {
+            uint32_t h = '[';
+            for (JsonVariantConst item : value.as<JsonArrayConst>()) {
+                h = mix(h, ofValue(item));
+            }
+            return h;
+        }
+        
+        Writer writer;
+        serializeJson(value, writer);
+        return writer.h;
+    }
+    
+private:
+    // ArduinoJson writer feeding serialized bytes into FNV-1a
+    struct Writer {
+        uint32_t h = 2166136261UL;
+        
+        size_t write(uint8_t c) {
+            h = (uint32_t)((h ^ c) * 16777619UL);
+            return 1;
+        }
+        
+        size_t write(const uint8_t* s, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                write(s[i]);
+            }
+            return n;
+        }
+    };
+    
+    static uint32_t mix(uint32_t a, uint32_t b) {
+        return (uint32_t)((a ^ (b + 0x9E3779B9UL + (a << 6) + (a >> 2))) * 16777619UL);
+    }
+};
+
+// Precomputed hashes of the built-in introspection methods
+struct RpcBuiltin {
+    static constexpr uint32_t LIST_METHODS = RpcHash::fnv1a("__rpc.listMethods");
+    static constexpr uint32_t VERSION = RpcHash::fnv1a("__rpc.version");
+    static constexpr uint32_t DESCRIBE = RpcHash::fnv1a("__rpc.describe");
+    static constexpr uint32_t CAPABILITIES = RpcHash::fnv1a("__rpc.capabilities");
+    static constexpr uint32_t STATS = RpcHash::fnv1a("__rpc.stats");
+    static constexpr uint32_t SUBSCRIBE = RpcHash::fnv1a("__rpc.subscribe");
+    static constexpr uint32_t UNSUBSCRIBE = RpcHash::fnv1a("__rpc.unsubscribe");
+    static constexpr uint32_t METHOD_IDS = RpcHash::fnv1a("__rpc.methodIds");
+};
+
+#if RPC_ENABLE_THREADED
+// Where a method's handler runs in threaded mode (see RpcWorker)
+enum RpcExecContext : uint8_t {
+    RPC_RUN_ON_WORKER,  // Inline on the worker task (default)
+    RPC_RUN_ON_LOOP     // Deferred to RpcWorker::runLoopHandlers() in loop()
+};
+#endif
+
+#if RPC_ENABLE_METRICS
+// ============================================================================
+// Metrics (if RPC_ENABLE_METRICS)
+// ============================================================================
+
+// Counters kept per registered method
+struct RpcMethodStats {
+    uint32_t calls;         // Handler invocations
+    uint32_t errors;        // Error replies (error code, exception, -32602 from typed params)
+    uint32_t totalMicros;   // Time spent in the handler
+    uint32_t maxMicros;     // Slowest single invocation
+    uint32_t bytesIn;       // Encoded request size
+    uint32_t bytesOut;      // Encoded response size
+    uint32_t cacheHits;     // Replies served from the response cache
+};
+
+// Server-wide counters
+struct RpcServerStats {
+    uint32_t requests;         // Well-formed requests dispatched
+    uint32_t parseErrors;      // Payloads that failed to decode
+    uint32_t invalidRequests;  // Decoded but not valid JSON-RPC
+    uint32_t notFound;         // Unknown method names
+    uint32_t droppedFrames;    // Oversize frames dropped by transports
+};
+#endif // RPC_ENABLE_METRICS
+
 // ============================================================================
 // RPC Request
 // ============================================================================
 
 class RpcRequest {
 public:
-    String jsonrpc;        // Always "2.0"
-    String method;         // Method name
-    JsonObject params;     // Method parameters
+    // jsonrpc and method point into the request document: they are only
+    // valid while the document that was parsed is alive (no String copies)
+    const char* jsonrpc;   // Always "2.0"
+    const char* method;    // Method name ("" when called by ID)
+    JsonVariant params;    // Method parameters: object (named), array (positional) or null
     JsonVariant id;        // Request ID (null for notifications)
+#if RPC_ENABLE_METHOD_IDS
+    int32_t methodId;      // Numeric method ID, -1 when called by name
+#endif
     
-    RpcRequest() : jsonrpc("2.0") {}
+#if RPC_ENABLE_METHOD_IDS
+    RpcRequest() : jsonrpc("2.0"), method(""), methodId(-1) {}
+#else
+    RpcRequest() : jsonrpc("2.0"), method("") {}
+#endif
     
     bool isNotification() const {
         return id.isNull();
     }
     
+    bool hasMethodId() const {
+#if RPC_ENABLE_METHOD_IDS
+        return methodId >= 0;
+#else
+        return false;
+#endif
+    }
+    
     bool isValid() const {
-        return jsonrpc == "2.0" && !method.isEmpty();
+        return jsonrpc && method && strcmp(jsonrpc, "2.0") == 0 && (method[0] != '\0' || hasMethodId());
     }
 };
 
@@ -56,16 +228,30 @@ public:
 
 class RpcResponse {
 private:
-    StaticJsonDocument<RPC_JSON_DOC_SIZE> doc;
+    RpcDocument<RPC_JSON_DOC_SIZE> doc;
+    int16_t item;  // Batch reply: index of the selected response, -1 for the whole document
     bool _hasError;
     bool _isValid;
     
+    // The response the accessors read: the document or the selected batch item
+    JsonVariantConst root() const {
+        return item < 0 ? doc.as<JsonVariantConst>() : doc[(size_t)item];
+    }
+    
+    bool check() {
+        _hasError = root().containsKey("error");
+        _isValid = root()["jsonrpc"] == "2.0";
+        return _isValid;
+    }
+    
 public:
-    RpcResponse() : _hasError(false), _isValid(false) {}
+    RpcResponse() : item(-1), _hasError(false), _isValid(false) {}
     
-    // Success response
-    void setResult(JsonVariant result, JsonVariant id) {
+    // Success response (id: JsonVariant, integer or nullptr)
+    template<typename TId>
+    void setResult(JsonVariant result, const TId& id) {
         doc.clear();
+        item = -1;
         doc["jsonrpc"] = "2.0";
         doc["result"] = result;
         doc["id"] = id;
@@ -73,9 +259,11 @@ public:
         _isValid = true;
     }
     
-    // Error response
-    void setError(int code, const char* message, JsonVariant id) {
+    // Error response (id: JsonVariant, integer or nullptr)
+    template<typename TId>
+    void setError(int code, const char* message, const TId& id) {
         doc.clear();
+        item = -1;
         doc["jsonrpc"] = "2.0";
         JsonObject error = doc.createNestedObject("error");
         error["code"] = code;
@@ -85,24 +273,42 @@ public:
         _isValid = true;
     }
     
-    // Parse from JSON string
-    bool parse(const String& json) {
-        DeserializationError error = deserializeJson(doc, json);
+    // Parse from JSON (or MessagePack) string
+    bool parse(const String& json, RpcFormat format = RPC_FORMAT_JSON) {
+        item = -1;
+        DeserializationError error = RpcCodec::decode(doc, json.c_str(), json.length(), format);
         if (error) {
             RPC_LOG_F("Failed to parse response: %s", error.c_str());
             _isValid = false;
             return false;
         }
         
-        _hasError = doc.containsKey("error");
-        _isValid = doc["jsonrpc"] == "2.0";
-        return _isValid;
+        if (isBatch()) {
+            // Read each response through selectItem()
+            _hasError = false;
+            _isValid = batchSize() > 0;
+            return _isValid;
+        }
+        return check();
+    }
+    
+    // Batch reply (an array of responses)
+    bool isBatch() const { return doc.is<JsonArrayConst>(); }
+    size_t batchSize() const { return isBatch() ? doc.size() : 0; }
+    
+    // Point every accessor at one response of a batch reply
+    bool selectItem(size_t index) {
+        if (index >= batchSize()) {
+            return false;
+        }
+        item = (int16_t)index;
+        return check();
     }
     
-    // Serialize to JSON string
-    String toString() const {
+    // Serialize to JSON (or MessagePack) string
+    String toString(RpcFormat format = RPC_FORMAT_JSON) const {
         String output;
-        serializeJson(doc, output);
+        RpcCodec::encode(root(), output, format);
         return output;
     }
     
@@ -115,29 +321,44 @@ public:
     template<typename T>
     T result() const {
         if (_hasError) return T();
-        return doc["result"].as<T>();
+        return root()["result"].as<T>();
     }
     
     // Get result as JsonVariant
-    JsonVariant result() const {
-        return doc["result"];
+    JsonVariantConst result() const {
+        return root()["result"];
     }
     
     // Get error code
     int errorCode() const {
         if (!_hasError) return 0;
-        return doc["error"]["code"];
+        return root()["error"]["code"];
     }
     
     // Get error message
     String errorMessage() const {
         if (!_hasError) return "";
-        return doc["error"]["message"].as<String>();
+        return root()["error"]["message"].as<String>();
     }
     
     // Get ID
-    JsonVariant id() const {
-        return doc["id"];
+    JsonVariantConst id() const {
+        return root()["id"];
+    }
+    
+    // Server-initiated notification (carries a method instead of a result)
+    bool isNotification() const {
+        return root().containsKey("method");
+    }
+    
+    // Notification method name (the topic for subscriptions)
+    const char* method() const {
+        return root()["method"] | "";
+    }
+    
+    // Notification params
+    JsonVariantConst params() const {
+        return root()["params"];
     }
 };
 
@@ -147,6 +368,8 @@ public:
 
 #if RPC_ENABLE_SAFE_MODE
 
+// Manual helpers. RpcCodec already applies safe mode to every JSON message
+// (see RpcSafeCodec), so handlers normally read and write plain values.
 class RpcSafe {
 public:
     /**
@@ -191,8 +414,9 @@ public:
      * Deserialize a safe date (remove D: prefix and parse)
      */
     static unsigned long deserializeDate(const String& value) {
-        if (value.startsWith("D:")) {
-            return value.substring(2).toInt();
+        long long timestamp;
+        if (value.startsWith("D:") && RpcSafeCodec::parseInt64(value.c_str() + 2, value.length() - 2, timestamp)) {
+            return (unsigned long)timestamp;
         }
         return 0;
     }
@@ -201,9 +425,9 @@ public:
      * Deserialize a BigInt (remove 'n' suffix)
      */
     static long long deserializeBigInt(const String& value) {
-        if (value.endsWith("n")) {
-            String numStr = value.substring(0, value.length() - 1);
-            return numStr.toInt();  // Note: Arduino long is 32-bit, limited range
+        long long result;
+        if (value.endsWith("n") && RpcSafeCodec::parseInt64(value.c_str(), value.length() - 1, result)) {
+            return result;
         }
         return 0;
     }
@@ -269,6 +493,44 @@ public:
         resp.setError(RPC_ERROR_INTERNAL, "Internal error", id);
         return resp;
     }
+    
+    /**
+     * Standard message for a JSON-RPC error code
+     */
+    static const char* message(int code) {
+        switch (code) {
+            case RPC_ERROR_PARSE:            return "Parse error";
+            case RPC_ERROR_INVALID_REQ:      return "Invalid Request";
+            case RPC_ERROR_METHOD_NOT_FOUND: return "Method not found";
+            case RPC_ERROR_INVALID_PARAMS:   return "Invalid params";
+            case RPC_ERROR_INTERNAL:         return "Internal error";
+            default:                         return "Server error";
+        }
+    }
+    
+    /**
+     * Write an error response object into an existing document
+     * (used by the server to build replies without an RpcResponse)
+     */
+    static void write(JsonObject out, int code, const char* message, JsonVariantConst id) {
+        out["jsonrpc"] = "2.0";
+        JsonObject error = out.createNestedObject("error");
+        error["code"] = code;
+        error["message"] = message;
+        out["id"] = id;
+    }
+    
+    static void writeMethodNotFound(JsonObject out, const char* method, JsonVariantConst id) {
+        // char* (not const char*) makes ArduinoJson copy the message
+        char msg[RPC_MAX_METHOD_NAME + 20];
+        snprintf(msg, sizeof(msg), "Method not found: %s", method);
+        
+        out["jsonrpc"] = "2.0";
+        JsonObject error = out.createNestedObject("error");
+        error["code"] = RPC_ERROR_METHOD_NOT_FOUND;
+        error["message"] = (char*)msg;
+        out["id"] = id;
+    }
 };
 
 #endif // RPC_TYPES_H
@@ -2,15 +2,19 @@
  * RPC Arduino Toolkit - WiFi Transport
  * 
  * Transport over WiFi (ESP32/ESP8266)
+ * 
+ * Bodies are handled by length, so both RPC_FORMAT_JSON and
+ * RPC_FORMAT_MSGPACK can be carried; the Content-Type of replies follows
+ * the format.
  */
 
 #ifndef RPC_WIFI_TRANSPORT_H
 #define RPC_WIFI_TRANSPORT_H
 
-#if RPC_HAS_WIFI
-
 #include "RpcTransport.h"
 
+#if RPC_HAS_WIFI
+
 #if defined(ESP32)
   #include <WiFi.h>
 #elif defined(ESP8266)
@@ -22,61 +26,137 @@ private:
     WiFiClient& client;
     char buffer[RPC_MAX_REQUEST_SIZE];
     
-public:
-    explicit RpcWiFiTransport(WiFiClient& c) : client(c) {
-        setTimeout(RPC_WIFI_TIMEOUT);
-    }
-    
-    String read() override {
+    // Read one request body into buffer (HTTP headers skipped). The body
+    // is read by Content-Length when one is given; JSON is trimmed in place,
+    // binary bodies are returned as-is.
+    char* receive(size_t& len) {
+        len = 0;
         if (!client.available()) {
-            return "";
+            return nullptr;
         }
         
-        // Read HTTP request line (for servers)
-        String line = client.readStringUntil('\n');
-        line.trim();
+        size_t contentLength = 0;
         
-        // If it's an HTTP request, skip headers
-        if (line.startsWith("POST") || line.startsWith("GET")) {
+        // HTTP request (for servers): skip the request line and headers. A
+        // bare body starts with '{', '[' or a MessagePack type byte and is
+        // left untouched.
+        int first = client.peek();
+        if (first == 'P' || first == 'G') {
+            String line = client.readStringUntil('\n');
+            
             // Skip headers until empty line
             while (client.available()) {
                 line = client.readStringUntil('\n');
                 line.trim();
                 if (line.isEmpty()) break;
+                line.toLowerCase();
+                if (line.startsWith("content-length:")) {
+                    contentLength = line.substring(15).toInt();
+                }
             }
         }
         
-        // Read JSON body
-        size_t len = 0;
+        // Read the body, waiting for the rest of a split one up to the timeout
+        size_t want = contentLength && contentLength < sizeof(buffer) ? contentLength : sizeof(buffer) - 1;
         unsigned long start = millis();
-        while (client.available() && len < sizeof(buffer) - 1 && (millis() - start < timeout)) {
-            buffer[len++] = client.read();
+        while (len < want && (millis() - start < timeout)) {
+            if (client.available()) {
+                buffer[len++] = client.read();
+            } else if (!contentLength || !client.connected()) {
+                break;
+            } else {
+                yield();
+            }
         }
-        buffer[len] = '\0';
         
-        String result(buffer);
-        result.trim();
+        char* body = buffer;
+        if (format == RPC_FORMAT_JSON) {
+            while (len > 0 && isspace((unsigned char)*body)) {
+                body++;
+                len--;
+            }
+            while (len > 0 && isspace((unsigned char)body[len - 1])) {
+                len--;
+            }
+            RPC_LOG_F("WiFi RX: %.*s", (int)len, body);
+        }
+        body[len] = '\0';
+        return body;
+    }
+    
+    const char* contentType() const {
+        return format == RPC_FORMAT_MSGPACK ? "application/msgpack" : "application/json";
+    }
+    
+    // HTTP response head for a body of length bytes, in one write
+    void sendHead(size_t length) {
+        char head[128];
+        int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nConnection: close\r\nContent-Length: %u\r\n\r\n",
+                         contentType(), (unsigned)length);
+        client.write((const uint8_t*)head, n);
+    }
+    
+public:
+    explicit RpcWiFiTransport(WiFiClient& c) : client(c) {
+        setTimeout(RPC_WIFI_TIMEOUT);
+    }
+    
+    String read() override {
+        size_t len;
+        char* body = receive(len);
         
-        RPC_LOG_F("WiFi RX: %s", result.c_str());
+        String result;
+        if (body) {
+            result.reserve(len);
+            RpcCodec::appendBytes(result, (const uint8_t*)body, len);
+        }
         return result;
     }
     
-    bool write(const String& data) override {
-        RPC_LOG_F("WiFi TX: %s", data.c_str());
+    bool hasFrameBuffer() const override {
+        return true;
+    }
+    
+    char* peekFrame(size_t& len) override {
+        char* body = receive(len);
+        return len ? body : nullptr;
+    }
+    
+    bool writeFrame(const char* data, size_t len) override {
+        if (format == RPC_FORMAT_JSON) {
+            RPC_LOG_F("WiFi TX: %.*s", (int)len, data);
+        }
         
-        // Send as HTTP response
-        client.println("HTTP/1.1 200 OK");
-        client.println("Content-Type: application/json");
-        client.println("Connection: close");
-        client.print("Content-Length: ");
-        client.println(data.length());
-        client.println();
-        client.println(data);
+        // Send as HTTP response: exactly Content-Length bytes of body
+        sendHead(len);
+        client.write((const uint8_t*)data, len);
         client.flush();
         
         return true;
     }
     
+    bool write(const String& data) override {
+        return writeFrame(data.c_str(), data.length());
+    }
+    
+    bool writeDocument(JsonVariantConst doc) override {
+        // Send as HTTP response, serialized straight into the client
+        sendHead(RpcCodec::measure(doc, format));
+        {
+            RpcBufferedPrint<> out(client);
+            RpcCodec::encode(doc, out, format);
+        }
+        client.flush();
+        
+        return true;
+    }
+    
+    // Replies are HTTP responses: nothing can be pushed
+    bool canPush() const override {
+        return false;
+    }
+    
     bool available() override {
         return client.connected() && client.available();
     }
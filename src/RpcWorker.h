@@ -0,0 +1,249 @@
+/**
+ * RPC Arduino Toolkit - Threaded Server Worker (ESP32)
+ * 
+ * Moves transport I/O, parsing and dispatch off the Arduino loop(): a
+ * worker task owns the attached transports and runs handlers inline,
+ * except for methods marked RPC_RUN_ON_LOOP with
+ * RpcServer::setMethodContext(). Those requests are handed to loop()
+ * through a lock-free SPSC queue of pre-sized documents, and their
+ * replies come back the same way.
+ * 
+ * Usage:
+ *   RpcServer<8> rpc;
+ *   RpcWorker<8> worker(rpc);
+ * 
+ *   void setup() {
+ *       rpc.addMethod("setSpeed", ...);
+ *       rpc.setMethodContext("setSpeed", RPC_RUN_ON_LOOP);
+ *       worker.attach(transport);
+ *       worker.begin();
+ *   }
+ * 
+ *   void loop() {
+ *       motorControl();
+ *       worker.runLoopHandlers();
+ *   }
+ * 
+ * step() performs one worker iteration without any FreeRTOS call, so the
+ * worker can also be driven from a std::thread on a host machine.
+ */
+
+#ifndef RPC_WORKER_H
+#define RPC_WORKER_H
+
+#include "RpcConfig.h"
+
+#if RPC_ENABLE_THREADED
+
+#include "RpcServer.h"
+#include "RpcSpscQueue.h"
+
+#if defined(ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+#endif
+
+// One request or reply in flight between the worker and loop()
+struct RpcJob {
+    StaticJsonDocument<RPC_JSON_DOC_SIZE> doc;
+    uint8_t transport;  // Index of the originating transport
+    RpcFormat format;
+    bool hasReply;      // false for notifications (nothing to write back)
+};
+
+template<uint8_t MAX_METHODS = RPC_MAX_METHODS>
+class RpcWorker {
+private:
+    RpcServer<MAX_METHODS>& rpc;
+    
+    // A transport with a request parked in loop() is not read again until
+    // the reply is written, so request/reply pairing (HTTP) is preserved
+    RpcTransport* transports[RPC_MAX_TRANSPORTS];
+    bool waiting[RPC_MAX_TRANSPORTS];
+    uint8_t transportCount;
+    
+    RpcSpscQueue<RpcJob, RPC_WORKER_QUEUE_SIZE> requests;  // Worker -> loop()
+    RpcSpscQueue<RpcJob, RPC_WORKER_QUEUE_SIZE> replies;   // loop() -> worker
+    
+    char frame[RPC_MAX_REQUEST_SIZE];
+    StaticJsonDocument<RPC_JSON_DOC_SIZE> reply;
+    
+#if defined(ESP32)
+    TaskHandle_t task;
+    
+    static void taskEntry(void* arg) {
+        RpcWorker* self = static_cast<RpcWorker*>(arg);
+        for (;;) {
+            if (!self->step()) {
+                vTaskDelay(1);  // Idle: let lower-priority tasks (and the watchdog) run
+            }
+        }
+    }
+#endif
+    
+    // True if the request (or any item of a batch) must run in loop()
+    bool needsLoop(JsonVariantConst request) {
+        if (request.is<JsonArrayConst>()) {
+            for (JsonVariantConst item : request.as<JsonArrayConst>()) {
+                if (needsLoop(item)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+#if RPC_ENABLE_METHOD_IDS
+        if (request["method"].is<uint32_t>()) {
+            return rpc.getMethodContext(request["method"].as<uint32_t>()) == RPC_RUN_ON_LOOP;
+        }
+#endif
+        const char* method = request["method"] | "";
+        return rpc.getMethodContext(method) == RPC_RUN_ON_LOOP;
+    }
+    
+public:
+    explicit RpcWorker(RpcServer<MAX_METHODS>& server)
+        : rpc(server), transportCount(0) {
+#if defined(ESP32)
+        task = nullptr;
+#endif
+    }
+    
+    /**
+     * Hand a transport to the worker (call before begin())
+     * From then on only the worker task may read or write it.
+     */
+    bool attach(RpcTransport& transport) {
+        if (transportCount >= RPC_MAX_TRANSPORTS) {
+            RPC_LOG("Transport table full");
+            return false;
+        }
+        
+        waiting[transportCount] = false;
+        transports[transportCount++] = &transport;
+        return true;
+    }
+    
+#if defined(ESP32)
+    /**
+     * Start the worker task
+     * Register methods and their contexts first: the method table is read
+     * by both cores once the task runs.
+     */
+    bool begin(BaseType_t core = RPC_WORKER_CORE, UBaseType_t priority = 1) {
+        if (task) {
+            return false;
+        }
+        return xTaskCreatePinnedToCore(taskEntry, "rpcWorker", RPC_WORKER_STACK_SIZE,
+                                       this, priority, &task, core) == pdPASS;
+    }
+    
+    bool isRunning() const {
+        return task != nullptr;
+    }
+#endif
+    
+    /**
+     * One worker iteration: write back replies produced by loop(), then read
+     * at most one frame from each transport and dispatch it
+     * @return true if any work was done
+     */
+    bool step() {
+        bool busy = false;
+        
+        while (RpcJob* job = replies.front()) {
+            if (job->hasReply) {
+                transports[job->transport]->writeDocument(job->doc);
+            }
+            waiting[job->transport] = false;
+            replies.pop();
+            busy = true;
+        }
+        
+        for (uint8_t i = 0; i < transportCount; i++) {
+            if (waiting[i]) {
+                continue;
+            }
+            
+            // Decode straight into a queue slot; it is only published if
+            // the request has to run in loop()
+            RpcJob* job = requests.reserve();
+            if (!job) {
+                break;  // loop() is behind: leave frames in the transports
+            }
+            
+            RpcTransport* transport = transports[i];
+            size_t len = transport->readFrame(frame, sizeof(frame));
+            rpc.replyDropped(*transport);
+            if (len == 0) {
+                continue;
+            }
+            busy = true;
+            
+            RpcFormat format = transport->getFormat();
+            DeserializationError error = RpcCodec::decode(job->doc, frame, len, format);
+            if (error) {
+                RPC_LOG_F("Parse error: %s", error.c_str());
+                RpcError::write(reply.to<JsonObject>(), RPC_ERROR_PARSE, "Parse error", JsonVariantConst());
+                transport->writeDocument(reply);
+                continue;
+            }
+            
+            if (needsLoop(job->doc)) {
+                job->transport = i;
+                job->format = format;
+                waiting[i] = true;
+                requests.commit();
+                continue;
+            }
+            
+            if (rpc.handleDocument(job->doc, reply, format)) {
+                transport->writeDocument(reply);
+            }
+        }
+        
+        return busy;
+    }
+    
+    /**
+     * Run the handlers deferred to loop() (call from loop())
+     * A batch containing any RPC_RUN_ON_LOOP method runs here as a whole.
+     * @return Number of requests handled
+     */
+    uint8_t runLoopHandlers(uint8_t maxRequests = RPC_POLL_MAX_REQUESTS) {
+        uint8_t handled = 0;
+        
+        while (handled < maxRequests) {
+            RpcJob* request = requests.front();
+            if (!request) {
+                break;
+            }
+            
+            RpcJob* out = replies.reserve();
+            if (!out) {
+                break;  // Worker has not collected earlier replies yet
+            }
+            
+            out->transport = request->transport;
+            out->format = request->format;
+            out->hasReply = rpc.handleDocument(request->doc, out->doc, request->format);
+            
+            requests.pop();
+            replies.commit();
+            handled++;
+        }
+        
+        return handled;
+    }
+    
+    /**
+     * Requests waiting for runLoopHandlers()
+     */
+    uint8_t pendingLoopRequests() const {
+        return requests.size();
+    }
+};
+
+#endif // RPC_ENABLE_THREADED
+
+#endif // RPC_WORKER_H
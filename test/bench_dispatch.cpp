@@ -0,0 +1,63 @@
+/**
+ * RPC Arduino Toolkit - Dispatch Benchmark (host)
+ * 
+ * Host build of examples/Benchmark: server dispatch on the String and
+ * buffer paths, a client round trip over RpcLoopbackTransport and the
+ * safe mode helpers. Reports calls/sec, p50/p99 latency and heap
+ * allocations and bytes per call.
+ */
+
+#define RPC_ENABLE_SAFE_MODE 1
+#include <RpcServer.h>
+#include <RpcClient.h>
+#include <RpcLoopbackTransport.h>
+#include "HostBench.h"
+
+RpcServer<8> rpc;
+RpcLoopbackTransport loopback([](const String& request) {
+    return rpc.handleRequest(request);
+});
+RpcClient client(loopback);
+
+const char* ADD_REQUEST = "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":5,\"b\":3},\"id\":1}";
+char out[RPC_MAX_RESPONSE_SIZE];
+
+int main(int argc, char** argv) {
+    HostBench bench(argc, argv);
+    
+    rpc.addMethod("add", [](JsonObjectConst params, JsonVariant result) {
+        result.set((params["a"] | 0) + (params["b"] | 0));
+    });
+    
+    // Server dispatch
+    String request(ADD_REQUEST);
+    bench.run("server handleRequest(String)", [&]() {
+        rpc.handleRequest(request);
+    });
+    
+    size_t requestLen = strlen(ADD_REQUEST);
+    bench.run("server handleRequest(buffer)", [&]() {
+        rpc.handleRequest(ADD_REQUEST, requestLen, out, sizeof(out));
+    });
+    
+    // Client round trip through the loopback transport
+    bench.run("client call (loopback)", []() {
+        client.call("add", "{\"a\":5,\"b\":3}");
+    });
+    loopback.resetCounters();
+    client.call("add", "{\"a\":5,\"b\":3}");
+    printf("  wire bytes/call: %u out, %u in\n", (unsigned)loopback.bytesWritten(), (unsigned)loopback.bytesRead());
+    
+    // Safe mode helpers
+    bench.run("RpcSafe string", []() {
+        String s = RpcSafe::serializeString("hello");
+        RpcSafe::deserializeString(s);
+    });
+    
+    bench.run("RpcSafe bigint", []() {
+        String s = RpcSafe::serializeBigInt(9007199254740993LL);
+        RpcSafe::deserializeBigInt(s);
+    });
+    
+    return 0;
+}
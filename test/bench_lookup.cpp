@@ -0,0 +1,61 @@
+/**
+ * RPC Arduino Toolkit - Method Lookup Benchmark (host)
+ * 
+ * Host build of examples/LookupBenchmark: dispatch cost with 8, 32 and
+ * 128 registered methods, for a hit on the last registered method (the
+ * worst case for a linear scan), a miss and a built-in method. With the
+ * hashed index the figures stay flat as the table grows.
+ */
+
+#include <RpcServer.h>
+#include "HostBench.h"
+
+RpcServer<8> rpc8;
+RpcServer<32> rpc32;
+RpcServer<128> rpc128;
+
+char out[128];
+
+template<uint8_t N>
+void registerMethods(RpcServer<N>& rpc) {
+    char name[16];
+    for (uint8_t i = 0; i < N; i++) {
+        snprintf(name, sizeof(name), "method%u", i);
+        rpc.addMethod(name, [](JsonVariant, JsonVariant result) {
+            result.set(1);
+        });
+    }
+}
+
+template<uint8_t N>
+void runBenchmark(HostBench& bench, RpcServer<N>& rpc) {
+    char hit[80];
+    snprintf(hit, sizeof(hit), "{\"jsonrpc\":\"2.0\",\"method\":\"method%u\",\"id\":1}", N - 1);
+    const char* miss = "{\"jsonrpc\":\"2.0\",\"method\":\"missing\",\"id\":1}";
+    const char* builtin = "{\"jsonrpc\":\"2.0\",\"method\":\"__rpc.version\",\"id\":1}";
+    const char* requests[] = {hit, miss, builtin};
+    const char* labels[] = {"hit", "miss", "builtin"};
+    
+    char name[48];
+    for (int i = 0; i < 3; i++) {
+        const char* request = requests[i];
+        size_t len = strlen(request);
+        snprintf(name, sizeof(name), "%3u methods: %s", N, labels[i]);
+        bench.run(name, [&]() {
+            rpc.handleRequest(request, len, out, sizeof(out));
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    HostBench bench(argc, argv);
+    
+    registerMethods(rpc8);
+    registerMethods(rpc32);
+    registerMethods(rpc128);
+    
+    runBenchmark(bench, rpc8);
+    runBenchmark(bench, rpc32);
+    runBenchmark(bench, rpc128);
+    return 0;
+}
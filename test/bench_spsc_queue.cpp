@@ -0,0 +1,89 @@
+/**
+ * RPC Arduino Toolkit - SPSC Queue Benchmark (host)
+ * 
+ * Host build of examples/QueueBenchmark: RpcSpscQueue throughput
+ * between a producer and a consumer std::thread, with 4-byte items and
+ * with document-sized slots filled and read in place, the way RpcWorker
+ * hands requests to loop().
+ */
+
+#include <RpcSpscQueue.h>
+#include <thread>
+#include "HostBench.h"
+
+struct Job {
+    uint32_t id;
+    char doc[1024];
+};
+
+RpcSpscQueue<uint32_t, 16> numbers;
+RpcSpscQueue<Job, 2> jobs;
+RpcSpscQueue<Job, 8> deepJobs;
+
+template<uint8_t CAPACITY>
+void moveJobs(RpcSpscQueue<Job, CAPACITY>& queue, uint32_t count) {
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; ) {
+            Job* job = queue.reserve();
+            if (job) {
+                job->id = i;
+                job->doc[0] = (char)i;
+                queue.commit();
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    for (uint32_t expected = 0; expected < count; ) {
+        Job* job = queue.front();
+        if (job) {
+            if (job->id != expected++) {
+                printf("ORDER ERROR\n");
+            }
+            queue.pop();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
+
+int main(int argc, char** argv) {
+    HostBench bench(argc, argv, 10000000);
+    uint32_t items = (uint32_t)bench.count();
+    
+    bench.throughput("uint32 x16 slots (items/s)", items, [&]() {
+        std::thread producer([&]() {
+            for (uint32_t i = 0; i < items; ) {
+                if (numbers.push(i)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (uint32_t expected = 0; expected < items; ) {
+            uint32_t value;
+            if (numbers.pop(value)) {
+                if (value != expected++) {
+                    printf("ORDER ERROR\n");
+                }
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+    });
+    
+    bench.throughput("1 KB job x2 slots, in place (items/s)", items / 10, [&]() {
+        moveJobs(jobs, items / 10);
+    });
+    
+    bench.throughput("1 KB job x8 slots, in place (items/s)", items / 10, [&]() {
+        moveJobs(deepJobs, items / 10);
+    });
+    
+    return 0;
+}
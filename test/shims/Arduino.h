@@ -0,0 +1,595 @@
+/**
+ * RPC Arduino Toolkit - Host Arduino Shim
+ * 
+ * The minimal Arduino core the toolkit headers need to build natively
+ * (see test/CMakeLists.txt): String, Print, Stream, a millis()/micros()
+ * clock and the PROGMEM helpers, which are plain RAM accesses on a host.
+ * 
+ * String follows the Arduino WString layout (one heap block, grown on
+ * demand) so allocation counts measured on the host track what the same
+ * code asks of the heap on a board.
+ * 
+ * The clock is the host's monotonic clock plus an offset: delay() and
+ * hostAdvanceMillis() move it forward without sleeping, so timeouts can
+ * be tested instantly.
+ */
+
+#ifndef RPC_HOST_ARDUINO_H
+#define RPC_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// ============================================================================
+// Flash Strings (RAM on the host)
+// ============================================================================
+
+class __FlashStringHelper;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+
+// ============================================================================
+// Clock
+// ============================================================================
+
+inline uint64_t& hostClockOffsetMicros() {
+    static uint64_t offset = 0;
+    return offset;
+}
+
+inline uint64_t hostMicros64() {
+    static const auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + hostClockOffsetMicros();
+}
+
+inline unsigned long millis() {
+    return (unsigned long)(hostMicros64() / 1000);
+}
+
+inline unsigned long micros() {
+    return (unsigned long)hostMicros64();
+}
+
+/**
+ * Move the clock forward without sleeping (tests of timeouts)
+ */
+inline void hostAdvanceMillis(unsigned long ms) {
+    hostClockOffsetMicros() += (uint64_t)ms * 1000;
+}
+
+inline void delay(unsigned long ms) {
+    hostAdvanceMillis(ms);
+    std::this_thread::yield();
+}
+
+inline void delayMicroseconds(unsigned int us) {
+    hostClockOffsetMicros() += us;
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+// ============================================================================
+// String
+// ============================================================================
+
+class StringSumHelper;
+
+class String {
+private:
+    char* buf;
+    size_t len;
+    size_t cap;
+    
+    bool grow(size_t size) {
+        if (size <= cap && buf) {
+            return true;
+        }
+        char* p = (char*)realloc(buf, size + 1);
+        if (!p) {
+            return false;
+        }
+        if (!buf) {
+            p[0] = '\0';
+        }
+        buf = p;
+        cap = size;
+        return true;
+    }
+    
+    // Empty strings stay unallocated (like the ESP cores' small-string
+    // buffer), so String() costs nothing until something is appended
+    String& copy(const char* s, size_t n) {
+        if (!s) {
+            invalidate();
+            return *this;
+        }
+        if (n == 0 && !buf) {
+            len = 0;
+            return *this;
+        }
+        if (!grow(n)) {
+            invalidate();
+            return *this;
+        }
+        memmove(buf, s, n);
+        buf[n] = '\0';
+        len = n;
+        return *this;
+    }
+    
+    void invalidate() {
+        free(buf);
+        buf = nullptr;
+        len = cap = 0;
+    }
+    
+    void init() {
+        buf = nullptr;
+        len = cap = 0;
+    }
+    
+    template<typename T>
+    void fromNumber(const char* fmt, T value) {
+        char digits[32];
+        snprintf(digits, sizeof(digits), fmt, value);
+        copy(digits, strlen(digits));
+    }
+    
+public:
+    String(const char* s = "") {
+        init();
+        copy(s, s ? strlen(s) : 0);
+    }
+    
+    String(const char* s, size_t n) {
+        init();
+        copy(s, n);
+    }
+    
+    String(const __FlashStringHelper* s) : String((const char*)s) {}
+    
+    String(const String& other) {
+        init();
+        if (other.buf) {
+            copy(other.buf, other.len);
+        }
+    }
+    
+    String(String&& other) noexcept : buf(other.buf), len(other.len), cap(other.cap) {
+        other.init();
+    }
+    
+    explicit String(char c) {
+        init();
+        copy(&c, 1);
+    }
+    
+    explicit String(int value, unsigned char base = 10) { init(); fromNumber(base == 16 ? "%x" : "%d", value); }
+    explicit String(unsigned int value, unsigned char base = 10) { init(); fromNumber(base == 16 ? "%x" : "%u", value); }
+    explicit String(long value, unsigned char base = 10) { init(); fromNumber(base == 16 ? "%lx" : "%ld", value); }
+    explicit String(unsigned long value, unsigned char base = 10) { init(); fromNumber(base == 16 ? "%lx" : "%lu", value); }
+    explicit String(long long value) { init(); fromNumber("%lld", value); }
+    explicit String(unsigned long long value) { init(); fromNumber("%llu", value); }
+    explicit String(double value, unsigned char decimals = 2) {
+        init();
+        char digits[48];
+        snprintf(digits, sizeof(digits), "%.*f", decimals, value);
+        copy(digits, strlen(digits));
+    }
+    
+    ~String() {
+        free(buf);
+    }
+    
+    String& operator=(const String& other) {
+        if (this != &other) {
+            if (other.buf) {
+                copy(other.buf, other.len);
+            } else {
+                invalidate();
+            }
+        }
+        return *this;
+    }
+    
+    String& operator=(String&& other) noexcept {
+        if (this != &other) {
+            free(buf);
+            buf = other.buf;
+            len = other.len;
+            cap = other.cap;
+            other.init();
+        }
+        return *this;
+    }
+    
+    String& operator=(const char* s) {
+        return copy(s, s ? strlen(s) : 0);
+    }
+    
+    String& operator=(const __FlashStringHelper* s) {
+        return *this = (const char*)s;
+    }
+    
+    /**
+     * Reserve room for size characters (plus the terminator)
+     */
+    bool reserve(size_t size) {
+        return grow(size);
+    }
+    
+    // ------------------------------------------------------------------------
+    // Concatenation
+    // ------------------------------------------------------------------------
+    
+    bool concat(const char* s, size_t n) {
+        if (!s) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        if (!grow(len + n)) {
+            return false;
+        }
+        memmove(buf + len, s, n);
+        len += n;
+        buf[len] = '\0';
+        return true;
+    }
+    
+    bool concat(const char* s) { return s && concat(s, strlen(s)); }
+    bool concat(const String& s) { return concat(s.c_str(), s.length()); }
+    bool concat(const __FlashStringHelper* s) { return concat((const char*)s); }
+    bool concat(char c) { return concat(&c, 1); }
+    bool concat(unsigned char c) { return concat(String((unsigned int)c)); }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(long long value) { return concat(String(value)); }
+    bool concat(unsigned long long value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+    
+    template<typename T>
+    String& operator+=(const T& value) {
+        concat(value);
+        return *this;
+    }
+    
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, const String& rhs);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, const char* rhs);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, char rhs);
+    
+    // ------------------------------------------------------------------------
+    // Access
+    // ------------------------------------------------------------------------
+    
+    const char* c_str() const { return buf ? buf : ""; }
+    size_t length() const { return len; }
+    bool isEmpty() const { return len == 0; }
+    
+    char* begin() { return buf; }
+    char* end() { return buf ? buf + len : nullptr; }
+    const char* begin() const { return c_str(); }
+    const char* end() const { return c_str() + len; }
+    
+    char charAt(size_t i) const { return i < len ? buf[i] : '\0'; }
+    char operator[](size_t i) const { return charAt(i); }
+    char& operator[](size_t i) {
+        static char dummy;
+        return i < len ? buf[i] : (dummy = '\0');
+    }
+    
+    void setCharAt(size_t i, char c) {
+        if (i < len) {
+            buf[i] = c;
+        }
+    }
+    
+    // ------------------------------------------------------------------------
+    // Comparison and search
+    // ------------------------------------------------------------------------
+    
+    bool equals(const String& s) const { return len == s.len && memcmp(c_str(), s.c_str(), len) == 0; }
+    bool equals(const char* s) const { return s && strlen(s) == len && memcmp(c_str(), s, len) == 0; }
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool operator<(const String& s) const { return strcmp(c_str(), s.c_str()) < 0; }
+    
+    bool equalsIgnoreCase(const String& s) const {
+        if (len != s.len) {
+            return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            if (tolower((unsigned char)buf[i]) != tolower((unsigned char)s.buf[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool startsWith(const String& prefix, size_t offset = 0) const {
+        return offset + prefix.len <= len && memcmp(c_str() + offset, prefix.c_str(), prefix.len) == 0;
+    }
+    
+    bool endsWith(const String& suffix) const {
+        return suffix.len <= len && memcmp(c_str() + len - suffix.len, suffix.c_str(), suffix.len) == 0;
+    }
+    
+    int indexOf(char c, size_t from = 0) const {
+        for (size_t i = from; i < len; i++) {
+            if (buf[i] == c) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+    
+    int indexOf(const String& s, size_t from = 0) const {
+        if (from > len) {
+            return -1;
+        }
+        const char* found = strstr(c_str() + from, s.c_str());
+        return found ? (int)(found - c_str()) : -1;
+    }
+    
+    int lastIndexOf(char c) const {
+        for (size_t i = len; i > 0; i--) {
+            if (buf[i - 1] == c) {
+                return (int)(i - 1);
+            }
+        }
+        return -1;
+    }
+    
+    String substring(size_t from, size_t to = (size_t)-1) const {
+        if (to > len) {
+            to = len;
+        }
+        if (from >= to) {
+            return String();
+        }
+        return String(c_str() + from, to - from);
+    }
+    
+    // ------------------------------------------------------------------------
+    // Modification
+    // ------------------------------------------------------------------------
+    
+    void remove(size_t index, size_t count = (size_t)-1) {
+        if (index >= len) {
+            return;
+        }
+        if (count > len - index) {
+            count = len - index;
+        }
+        memmove(buf + index, buf + index + count, len - index - count + 1);
+        len -= count;
+    }
+    
+    void trim() {
+        if (!buf) {
+            return;
+        }
+        size_t start = 0;
+        while (start < len && isspace((unsigned char)buf[start])) {
+            start++;
+        }
+        size_t stop = len;
+        while (stop > start && isspace((unsigned char)buf[stop - 1])) {
+            stop--;
+        }
+        len = stop - start;
+        memmove(buf, buf + start, len);
+        buf[len] = '\0';
+    }
+    
+    void toLowerCase() {
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = (char)tolower((unsigned char)buf[i]);
+        }
+    }
+    
+    void toUpperCase() {
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = (char)toupper((unsigned char)buf[i]);
+        }
+    }
+    
+    long toInt() const { return strtol(c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(c_str(), nullptr); }
+    double toDouble() const { return strtod(c_str(), nullptr); }
+};
+
+// Result of a + chain (the type ArduinoJson adapts alongside String)
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* s) : String(s) {}
+};
+
+inline StringSumHelper& operator+(const StringSumHelper& lhs, const String& rhs) {
+    StringSumHelper& sum = const_cast<StringSumHelper&>(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper& operator+(const StringSumHelper& lhs, const char* rhs) {
+    StringSumHelper& sum = const_cast<StringSumHelper&>(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper& operator+(const StringSumHelper& lhs, char rhs) {
+    StringSumHelper& sum = const_cast<StringSumHelper&>(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline bool operator==(const char* lhs, const String& rhs) {
+    return rhs == lhs;
+}
+
+// ============================================================================
+// Print / Stream
+// ============================================================================
+
+class Print {
+public:
+    virtual ~Print() {}
+    
+    virtual size_t write(uint8_t c) = 0;
+    
+    virtual size_t write(const uint8_t* data, size_t size) {
+        size_t n = 0;
+        while (size-- > 0 && write(*data++)) {
+            n++;
+        }
+        return n;
+    }
+    
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* s, size_t size) { return write((const uint8_t*)s, size); }
+    
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+    
+    size_t print(const char* s) { return write(s); }
+    size_t print(const __FlashStringHelper* s) { return write((const char*)s); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = 10) { return printf(base == 16 ? "%lx" : "%ld", value); }
+    size_t print(unsigned long value, int base = 10) { return printf(base == 16 ? "%lx" : "%lu", value); }
+    size_t print(long long value) { return printf("%lld", value); }
+    size_t print(unsigned long long value) { return printf("%llu", value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    
+    template<typename T>
+    size_t println(const T& value) {
+        size_t n = print(value);
+        return n + println();
+    }
+    
+    size_t println() { return write("\r\n"); }
+    
+    size_t printf(const char* fmt, ...) {
+        char text[256];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(text, sizeof(text), fmt, args);
+        va_end(args);
+        if (n < 0) {
+            return 0;
+        }
+        return write((const uint8_t*)text, (size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1);
+    }
+};
+
+class Stream : public Print {
+protected:
+    unsigned long _timeout = 1000;
+    
+    int timedRead() {
+        unsigned long start = millis();
+        do {
+            int c = read();
+            if (c >= 0) {
+                return c;
+            }
+            yield();
+        } while (millis() - start < _timeout);
+        return -1;
+    }
+    
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+    
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = timedRead();
+            if (c < 0) {
+                break;
+            }
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        return readBytes((char*)buffer, length);
+    }
+    
+    size_t readBytesUntil(char terminator, char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = timedRead();
+            if (c < 0 || c == terminator) {
+                break;
+            }
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    
+    String readString() {
+        String s;
+        int c;
+        while ((c = timedRead()) >= 0) {
+            s += (char)c;
+        }
+        return s;
+    }
+    
+    String readStringUntil(char terminator) {
+        String s;
+        int c;
+        while ((c = timedRead()) >= 0 && c != terminator) {
+            s += (char)c;
+        }
+        return s;
+    }
+};
+
+#endif // RPC_HOST_ARDUINO_H
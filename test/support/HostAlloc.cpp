@@ -0,0 +1,118 @@
+/**
+ * RPC Arduino Toolkit - Host Allocation Counter
+ * 
+ * On glibc, malloc and friends are replaced by counting wrappers around
+ * the __libc_* entry points; that also covers operator new, which the C++
+ * runtime implements on top of malloc. Elsewhere only operator new and
+ * delete can be replaced portably.
+ */
+
+#include "HostAlloc.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+namespace {
+
+std::atomic<uint64_t> allocCount(0);
+std::atomic<uint64_t> freeCount(0);
+std::atomic<uint64_t> byteCount(0);
+
+inline void countAlloc(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    byteCount.fetch_add(size, std::memory_order_relaxed);
+}
+
+inline void countFree(void* p) {
+    if (p) {
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+    
+}  // namespace
+
+HostAllocStats hostAllocStats() {
+    HostAllocStats stats;
+    stats.allocations = allocCount.load(std::memory_order_relaxed);
+    stats.frees = freeCount.load(std::memory_order_relaxed);
+    stats.bytes = byteCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+#if defined(__GLIBC__)
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+
+void* malloc(size_t size) {
+    countAlloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    countAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+    if (size > 0) {
+        countAlloc(size);
+    } else {
+        countFree(p);
+    }
+    return __libc_realloc(p, size);
+}
+
+void free(void* p) {
+    countFree(p);
+    __libc_free(p);
+}
+    
+}  // extern "C"
+
+bool hostAllocCountsMalloc() {
+    return true;
+}
+
+#else
+
+void* operator new(size_t size) {
+    countAlloc(size);
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    countFree(p);
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+bool hostAllocCountsMalloc() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * RPC Arduino Toolkit - Host Allocation Counter
+ * 
+ * Counts every heap allocation the process makes (malloc, calloc,
+ * realloc and operator new), so tests can assert that a code path does
+ * not touch the heap and benchmarks can report allocations per call.
+ * 
+ * Usage:
+ *   HostAllocScope scope;
+ *   rpc.handleRequest(in, len, out, sizeof(out));
+ *   scope.allocations();  // 0 on the zero-allocation path
+ */
+
+#ifndef RPC_HOST_ALLOC_H
+#define RPC_HOST_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct HostAllocStats {
+    uint64_t allocations;  // malloc/calloc/realloc/new calls
+    uint64_t frees;        // free/delete calls on non-null pointers
+    uint64_t bytes;        // Bytes requested by the calls above
+};
+
+/**
+ * Counters since process start (all threads)
+ */
+HostAllocStats hostAllocStats();
+
+/**
+ * False when the platform's malloc could not be intercepted (only
+ * operator new/delete are counted then)
+ */
+bool hostAllocCountsMalloc();
+
+/**
+ * Allocations made between construction and the query
+ */
+class HostAllocScope {
+private:
+    HostAllocStats start;
+    
+public:
+    HostAllocScope() : start(hostAllocStats()) {}
+    
+    void restart() {
+        start = hostAllocStats();
+    }
+    
+    uint64_t allocations() const {
+        return hostAllocStats().allocations - start.allocations;
+    }
+    
+    uint64_t frees() const {
+        return hostAllocStats().frees - start.frees;
+    }
+    
+    uint64_t bytes() const {
+        return hostAllocStats().bytes - start.bytes;
+    }
+};
+
+#endif // RPC_HOST_ALLOC_H
@@ -0,0 +1,100 @@
+/**
+ * RPC Arduino Toolkit - Host Benchmark Runner
+ * 
+ * Times a callable over many iterations and prints one row per benchmark:
+ * calls per second, median and 99th percentile latency, and heap
+ * allocations and bytes per call (see HostAlloc.h).
+ * 
+ * Usage:
+ *   int main(int argc, char** argv) {
+ *       HostBench bench(argc, argv);
+ *       bench.run("handleRequest(buffer)", [&]() { ... });
+ *   }
+ * 
+ * --quick (used by ctest) runs a fraction of the iterations.
+ */
+
+#ifndef RPC_HOST_BENCH_H
+#define RPC_HOST_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "HostAlloc.h"
+
+class HostBench {
+private:
+    typedef std::chrono::steady_clock Clock;
+    
+    size_t iterations;
+    std::vector<uint32_t> samples;  // Nanoseconds per call
+    
+    double percentile(double p) const {
+        size_t i = (size_t)(p * (samples.size() - 1));
+        return samples[i] / 1000.0;
+    }
+    
+public:
+    HostBench(int argc, char** argv, size_t fullIterations = 100000) : iterations(fullIterations) {
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--quick") == 0) {
+                iterations = fullIterations / 100 > 100 ? fullIterations / 100 : 100;
+            }
+        }
+        samples.reserve(iterations);
+        printf("%-40s %12s %9s %9s %8s %8s\n", "benchmark", "calls/s", "p50 us", "p99 us", "allocs", "bytes");
+    }
+    
+    size_t count() const {
+        return iterations;
+    }
+    
+    /**
+     * Time fn() iterations times (after a short warm-up) and print the row
+     */
+    template<typename Fn>
+    void run(const char* name, Fn fn) {
+        for (size_t i = 0; i < iterations / 10 + 1; i++) {
+            fn();
+        }
+        
+        samples.clear();
+        HostAllocScope heap;
+        Clock::time_point begin = Clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            Clock::time_point start = Clock::now();
+            fn();
+            samples.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        uint64_t allocations = heap.allocations();
+        uint64_t bytes = heap.bytes();
+        
+        std::sort(samples.begin(), samples.end());
+        printf("%-40s %12.0f %9.2f %9.2f %8.2f %8.1f\n", name, iterations / seconds, percentile(0.50),
+               percentile(0.99), (double)allocations / iterations, (double)bytes / iterations);
+        fflush(stdout);
+    }
+    
+    /**
+     * Time a single fn() that moves items items (work that is not a series
+     * of independent calls, e.g. a producer and a consumer thread) and
+     * print the row with items per second and allocations per item
+     */
+    template<typename Fn>
+    void throughput(const char* name, size_t items, Fn fn) {
+        HostAllocScope heap;
+        Clock::time_point begin = Clock::now();
+        fn();
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        
+        printf("%-40s %12.0f %9s %9s %8.2f %8.1f\n", name, items / seconds, "-", "-",
+               (double)heap.allocations() / items, (double)heap.bytes() / items);
+        fflush(stdout);
+    }
+};
+
+#endif // RPC_HOST_BENCH_H
@@ -0,0 +1,145 @@
+/**
+ * RPC Arduino Toolkit - Loopback Sockets
+ * 
+ * Stand-ins for WiFiServer/WiFiClient with the members the HTTP server
+ * transport uses. A HostSocketServer hands out the server end of each
+ * connection made with connect(); the test keeps the client end. Both
+ * ends share one pair of byte queues, so copies of a HostSocket (the
+ * transport keeps one per connection slot) refer to the same socket.
+ * 
+ * Usage:
+ *   HostSocketServer server;
+ *   RpcHttpServerTransportT<HostSocketServer, HostSocket> http(server);
+ *   HostSocket peer = server.connect();
+ *   peer.print("POST / HTTP/1.1\r\n...");
+ */
+
+#ifndef RPC_HOST_SOCKET_H
+#define RPC_HOST_SOCKET_H
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class HostSocket : public Stream {
+private:
+    struct Pipe {
+        std::deque<uint8_t> bytes[2];    // Written by side 0 / side 1
+        bool open[2] = {true, true};
+        std::vector<size_t> writes[2];   // Size of every write() call
+        unsigned long readDelay = 0;     // Host clock advance per byte read (ms)
+    };
+    
+    std::shared_ptr<Pipe> pipe;
+    int side;
+    
+    std::deque<uint8_t>& rx() const { return pipe->bytes[1 - side]; }
+    
+public:
+    HostSocket() : side(0) {}
+    
+    // Both ends of a new connection: [0] is the server side
+    static void pair(HostSocket& server, HostSocket& client) {
+        server.pipe = client.pipe = std::make_shared<Pipe>();
+        server.side = 0;
+        client.side = 1;
+    }
+    
+    explicit operator bool() const { return pipe != nullptr; }
+    
+    bool connected() const { return pipe && pipe->open[0] && pipe->open[1]; }
+    
+    void stop() {
+        if (pipe) {
+            pipe->open[side] = false;
+        }
+    }
+    
+    int available() override { return pipe ? (int)rx().size() : 0; }
+    
+    int read() override {
+        if (!available()) {
+            return -1;
+        }
+        uint8_t c = rx().front();
+        rx().pop_front();
+        hostAdvanceMillis(pipe->readDelay);
+        return c;
+    }
+    
+    int peek() override { return available() ? rx().front() : -1; }
+    
+    // As WiFiClient::flush() on ESP32 core 2.x: unread input is discarded
+    void flush() override {
+        if (pipe) {
+            rx().clear();
+        }
+    }
+    
+    // Make every byte read on either end take ms of host time
+    void setReadDelay(unsigned long ms) {
+        if (pipe) {
+            pipe->readDelay = ms;
+        }
+    }
+    
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!connected()) {
+            return 0;
+        }
+        pipe->bytes[side].insert(pipe->bytes[side].end(), data, data + size);
+        pipe->writes[side].push_back(size);
+        return size;
+    }
+    
+    using Print::write;
+    
+    // Everything received so far, consumed
+    std::string take() {
+        std::string s;
+        while (available()) {
+            s += (char)read();
+        }
+        return s;
+    }
+    
+    // Sizes of the write() calls made on the other end, cleared
+    std::vector<size_t> takePeerWrites() {
+        std::vector<size_t> writes;
+        if (pipe) {
+            writes.swap(pipe->writes[1 - side]);
+        }
+        return writes;
+    }
+};
+
+class HostSocketServer {
+private:
+    std::deque<HostSocket> pending;
+    
+public:
+    // Open a connection; returns the client end
+    HostSocket connect() {
+        HostSocket server, client;
+        HostSocket::pair(server, client);
+        pending.push_back(server);
+        return client;
+    }
+    
+    bool hasClient() const { return !pending.empty(); }
+    
+    HostSocket available() {
+        HostSocket client;
+        if (!pending.empty()) {
+            client = pending.front();
+            pending.pop_front();
+        }
+        return client;
+    }
+};
+
+#endif // RPC_HOST_SOCKET_H
@@ -0,0 +1,88 @@
+/**
+ * RPC Arduino Toolkit - Host Test Macros
+ * 
+ * Minimal checks for the host tests: a failed CHECK prints its location
+ * and the test carries on; main() returns hostTestResult().
+ * 
+ * Usage:
+ *   void testAdd() {
+ *       CHECK_EQ(add(2, 3), 5);
+ *   }
+ *   int main() {
+ *       RUN_TEST(testAdd);
+ *       return hostTestResult();
+ *   }
+ */
+
+#ifndef RPC_HOST_TEST_H
+#define RPC_HOST_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+inline int& hostTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// Text of a CHECK_STR operand, copied so temporaries may be passed
+inline std::string hostTestText(const char* s) {
+    return s ? s : "(null)";
+}
+
+template<size_t N>
+std::string hostTestText(const char (&s)[N]) {
+    return s;
+}
+
+template<typename T>
+std::string hostTestText(const T& s) {
+    return s.c_str();
+}
+
+inline int hostTestResult() {
+    if (hostTestFailures() == 0) {
+        printf("All tests passed\n");
+        return 0;
+    }
+    printf("%d check(s) failed\n", hostTestFailures());
+    return 1;
+}
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures()++;                                          \
+        }                                                                  \
+    } while (0)
+    
+#define CHECK_EQ(actual, expected)                                                          \
+    do {                                                                                    \
+        long long a_ = (long long)(actual);                                                 \
+        long long e_ = (long long)(expected);                                               \
+        if (a_ != e_) {                                                                     \
+            printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+            hostTestFailures()++;                                                           \
+        }                                                                                   \
+    } while (0)
+    
+#define CHECK_STR(actual, expected)                                                     \
+    do {                                                                                \
+        std::string a_ = hostTestText(actual);                                          \
+        std::string e_ = hostTestText(expected);                                        \
+        if (a_ != e_) {                                                                 \
+            printf("%s:%d: %s == \"%s\",\n    expected \"%s\"\n", __FILE__, __LINE__, #actual, \
+                   a_.c_str(), e_.c_str());                                             \
+            hostTestFailures()++;                                                       \
+        }                                                                               \
+    } while (0)
+    
+#define RUN_TEST(fn)              \
+    do {                          \
+        printf("- %s\n", #fn);    \
+        fn();                     \
+    } while (0)
+    
+#endif // RPC_HOST_TEST_H
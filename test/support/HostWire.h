@@ -0,0 +1,151 @@
+/**
+ * RPC Arduino Toolkit - In-Memory Serial Link
+ * 
+ * Two HostWire byte queues make a full-duplex link; a HostStream is one
+ * end of it, usable wherever the toolkit takes a Stream (serial
+ * transports). Faults are injected per frame: bytes are held back until
+ * the frame delimiter is written, then the whole frame is delivered,
+ * corrupted or dropped.
+ * 
+ * Usage:
+ *   HostWire ab, ba;
+ *   HostStream a(ba, ab), b(ab, ba);   // a writes to ab, b reads it
+ *   a.dropFrames(1);                    // lose the next frame a sends
+ */
+
+#ifndef RPC_HOST_WIRE_H
+#define RPC_HOST_WIRE_H
+
+#include <Arduino.h>
+#include <deque>
+#include <string>
+
+struct HostWire {
+    std::deque<uint8_t> bytes;
+};
+
+class HostStream : public Stream {
+private:
+    HostWire& in;
+    HostWire& out;
+    int delimiter;           // Frame end byte, -1 for unframed (no faults)
+    std::string frame;       // Bytes of the frame being written
+    unsigned drops;          // Next frames to lose
+    unsigned corruptions;    // Next frames to damage
+    double dropRate;         // Random faults (soak tests)
+    double flipRate;
+    uint32_t seed;
+    uint32_t sent;
+    
+    double random() {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 8) & 0xFFFF) / 65536.0;
+    }
+    
+    void deliver() {
+        sent++;
+        if (drops > 0) {
+            drops--;
+            frame.clear();
+            return;
+        }
+        if (dropRate > 0 && random() < dropRate) {
+            frame.clear();
+            return;
+        }
+        
+        bool corrupt = corruptions > 0;
+        if (corrupt) {
+            corruptions--;
+        }
+        for (size_t i = 0; i < frame.size(); i++) {
+            uint8_t c = (uint8_t)frame[i];
+            if (corrupt && i == frame.size() / 2) {
+                c ^= 0x10;  // One flipped bit in the middle (never the delimiter)
+                if (c == delimiter) {
+                    c ^= 0x01;
+                }
+            } else if (flipRate > 0 && random() < flipRate) {
+                c ^= (uint8_t)(1 << (int)(random() * 8));
+            }
+            out.bytes.push_back(c);
+        }
+        out.bytes.push_back((uint8_t)delimiter);
+        frame.clear();
+    }
+    
+public:
+    HostStream(HostWire& rx, HostWire& tx, int frameDelimiter = -1)
+        : in(rx), out(tx), delimiter(frameDelimiter), drops(0), corruptions(0), dropRate(0), flipRate(0),
+          seed(1), sent(0) {}
+    
+    size_t write(uint8_t c) override {
+        if (delimiter < 0) {
+            out.bytes.push_back(c);
+            return 1;
+        }
+        if (c == delimiter) {
+            deliver();
+        } else {
+            frame.push_back((char)c);
+        }
+        return 1;
+    }
+    
+    int available() override {
+        return (int)in.bytes.size();
+    }
+    
+    int read() override {
+        if (in.bytes.empty()) {
+            return -1;
+        }
+        int c = in.bytes.front();
+        in.bytes.pop_front();
+        return c;
+    }
+    
+    int peek() override {
+        return in.bytes.empty() ? -1 : in.bytes.front();
+    }
+    
+    /**
+     * Lose the next n frames written to this end
+     */
+    void dropFrames(unsigned n) {
+        drops = n;
+    }
+    
+    /**
+     * Flip one bit in each of the next n frames written to this end
+     */
+    void corruptFrames(unsigned n) {
+        corruptions = n;
+    }
+    
+    /**
+     * Random faults: frames lost with probability drop, bytes damaged
+     * with probability flip (reproducible from seed)
+     */
+    void setNoise(double drop, double flip, uint32_t randomSeed) {
+        dropRate = drop;
+        flipRate = flip;
+        seed = randomSeed;
+    }
+    
+    /**
+     * Frames written to this end so far (including lost ones)
+     */
+    uint32_t framesSent() const {
+        return sent;
+    }
+    
+    /**
+     * Write raw bytes to the peer, bypassing fault injection
+     */
+    void inject(const char* data, size_t len) {
+        out.bytes.insert(out.bytes.end(), data, data + len);
+    }
+};
+
+#endif // RPC_HOST_WIRE_H
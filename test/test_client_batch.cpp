@@ -0,0 +1,113 @@
+/**
+ * RPC Arduino Toolkit - Client Batching Tests (host)
+ * 
+ * RpcClient batch frames sent through RpcSerialTransport to a second
+ * one over an in-memory link: a frame is split exactly where it would
+ * no longer fit the receiver's RPC_MAX_REQUEST_SIZE buffer, and every
+ * frame sent is accepted.
+ */
+
+#include <RpcClient.h>
+#include <RpcSerialTransport.h>
+#include <string>
+#include <vector>
+#include "HostTest.h"
+#include "HostWire.h"
+
+HostWire toServer, toClient;
+HostStream clientSide(toClient, toServer);
+HostStream serverSide(toServer, toClient);
+RpcSerialTransport clientLink(clientSide);
+RpcSerialTransport serverLink(serverSide);
+RpcClient client(clientLink);
+
+// Frames the receiving side accepted, in order
+std::vector<std::string> receive() {
+    std::vector<std::string> frames;
+    while (serverLink.available()) {
+        String frame = serverLink.read();
+        if (!frame.isEmpty()) {
+            frames.push_back(frame.c_str());
+        }
+    }
+    return frames;
+}
+
+void notifyPadded(size_t padding) {
+    String params = "{\"s\":\"";
+    for (size_t i = 0; i < padding; i++) {
+        params += 'x';
+    }
+    params += "\"}";
+    client.notify("m", params);
+}
+
+// Length of one notification with the given padding
+size_t requestLength(size_t padding) {
+    client.setBatching(false);
+    notifyPadded(padding);
+    std::vector<std::string> frames = receive();
+    return frames.size() == 1 ? frames[0].size() : 0;
+}
+
+// Queue two notifications whose batch frame "[a,b]" is frameLength long
+std::vector<std::string> sendPair(size_t frameLength) {
+    size_t base = requestLength(0);
+    size_t first = RPC_MAX_REQUEST_SIZE / 2 - base;
+    size_t second = frameLength - 3 - (base + first) - base;
+    
+    client.setBatching(true);
+    notifyPadded(first);
+    notifyPadded(second);
+    client.flush();
+    client.setBatching(false);
+    return receive();
+}
+
+void testPaddingMeasured() {
+    CHECK(requestLength(0) > 0);
+    CHECK_EQ(requestLength(10), requestLength(0) + 10);
+}
+
+void testLargestFrameBatched() {
+    uint32_t dropped = serverLink.droppedFrames();
+    std::vector<std::string> frames = sendPair(RPC_MAX_REQUEST_SIZE - 1);
+    
+    CHECK_EQ(frames.size(), 1);
+    if (frames.size() == 1) {
+        CHECK_EQ(frames[0].size(), RPC_MAX_REQUEST_SIZE - 1);
+        CHECK(frames[0][0] == '[');
+    }
+    CHECK_EQ(serverLink.droppedFrames(), dropped);
+}
+
+void testFullBufferSplits() {
+    // "[a,b]" would take the whole buffer, leaving no room for the terminator
+    uint32_t dropped = serverLink.droppedFrames();
+    std::vector<std::string> frames = sendPair(RPC_MAX_REQUEST_SIZE);
+    
+    CHECK_EQ(frames.size(), 2);
+    for (size_t i = 0; i < frames.size(); i++) {
+        CHECK(frames[i].size() < RPC_MAX_REQUEST_SIZE);
+        CHECK(frames[i][0] == '[');
+    }
+    CHECK_EQ(serverLink.droppedFrames(), dropped);
+}
+
+void testItemLimitSplits() {
+    client.setBatching(true);
+    for (int i = 0; i < RPC_MAX_BATCH_ITEMS + 1; i++) {
+        client.notify("m");
+    }
+    client.flush();
+    client.setBatching(false);
+    CHECK_EQ(receive().size(), 2);
+}
+
+int main() {
+    RUN_TEST(testPaddingMeasured);
+    RUN_TEST(testLargestFrameBatched);
+    RUN_TEST(testFullBufferSplits);
+    RUN_TEST(testItemLimitSplits);
+    return hostTestResult();
+}
@@ -0,0 +1,128 @@
+/**
+ * RPC Arduino Toolkit - Client Call Tests (host)
+ * 
+ * Blocking RpcClient::call() against an RpcServer over a loopback link,
+ * in each of its forms, including while queued async calls are flushed
+ * first and their callbacks start calls of their own.
+ */
+
+#include <RpcServer.h>
+#include <RpcClient.h>
+#include <RpcLoopbackTransport.h>
+#include "HostTest.h"
+
+RpcServer<4> rpc;
+
+// Loopback link that cannot carry batch frames
+class NoBatchLink : public RpcLoopbackTransport {
+public:
+    NoBatchLink() : RpcLoopbackTransport([](const String& request) {
+        return rpc.handleRequest(request);
+    }) {}
+    
+    bool write(const String& data) override {
+        if (data.startsWith("[")) {
+            return false;
+        }
+        return RpcLoopbackTransport::write(data);
+    }
+};
+
+NoBatchLink link;
+RpcClient client(link);
+
+int failedCallbacks = 0;
+
+void onFailed(RpcResponse& resp) {
+    if (resp.hasError()) {
+        failedCallbacks++;
+    }
+}
+
+// Queue an async call whose callback, fired by the failing flush at the
+// start of the next call(), queues another call
+void queueChainedCall() {
+    client.setBatching(true);
+    client.callAsync("add", "{\"a\":1,\"b\":1}", [](RpcResponse& resp) {
+        onFailed(resp);
+        client.callAsync("add", "{\"a\":2,\"b\":2}", onFailed);
+    });
+}
+
+void finish() {
+    client.setBatching(false);
+    client.poll();
+}
+
+void testStringParams() {
+    RpcResponse resp = client.call("add", "{\"a\":5,\"b\":3}");
+    CHECK(resp.isSuccess());
+    CHECK_EQ(resp.result<int>(), 8);
+}
+
+void testPositional() {
+    RpcResponse resp = client.call("add", 5, 3);
+    CHECK(resp.isSuccess());
+    CHECK_EQ(resp.result<int>(), 8);
+}
+
+void testWriter() {
+    RpcResponse resp = client.call("add", [](JsonVariant params) {
+        params["a"] = 5;
+        params["b"] = 3;
+    });
+    CHECK(resp.isSuccess());
+    CHECK_EQ(resp.result<int>(), 8);
+}
+
+void testStringAfterFlush() {
+    failedCallbacks = 0;
+    queueChainedCall();
+    RpcResponse resp = client.call("add", "{\"a\":5,\"b\":3}");
+    CHECK(resp.isSuccess());
+    CHECK_EQ(resp.result<int>(), 8);
+    finish();
+    CHECK_EQ(failedCallbacks, 2);
+}
+
+void testPositionalAfterFlush() {
+    failedCallbacks = 0;
+    queueChainedCall();
+    RpcResponse resp = client.call("add", 5, 3);
+    CHECK(resp.isSuccess());
+    CHECK_EQ(resp.result<int>(), 8);
+    finish();
+    CHECK_EQ(failedCallbacks, 2);
+}
+
+void testWriterAfterFlush() {
+    failedCallbacks = 0;
+    queueChainedCall();
+    RpcResponse resp = client.call("add", [](JsonVariant params) {
+        params["a"] = 5;
+        params["b"] = 3;
+    });
+    CHECK(resp.isSuccess());
+    CHECK_EQ(resp.result<int>(), 8);
+    finish();
+    CHECK_EQ(failedCallbacks, 2);
+}
+
+int main() {
+    rpc.addMethod("add", [](JsonVariant params, JsonVariant result) {
+        if (params.is<JsonArray>()) {
+            result.set((params[0] | 0) + (params[1] | 0));
+        } else {
+            result.set((params["a"] | 0) + (params["b"] | 0));
+        }
+    });
+    client.setTimeout(100);
+    
+    RUN_TEST(testStringParams);
+    RUN_TEST(testPositional);
+    RUN_TEST(testWriter);
+    RUN_TEST(testStringAfterFlush);
+    RUN_TEST(testPositionalAfterFlush);
+    RUN_TEST(testWriterAfterFlush);
+    return hostTestResult();
+}
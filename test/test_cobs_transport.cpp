@@ -0,0 +1,309 @@
+/**
+ * RPC Arduino Toolkit - COBS Transport Tests (host)
+ * 
+ * Two RpcCobsTransport ends over an in-memory link that loses or
+ * corrupts chosen frames: recovery by NAK and by the retry timer,
+ * selective retransmit, duplicate suppression, window overflow and a
+ * random-noise soak.
+ */
+
+#define RPC_COBS_WINDOW 4
+#include <RpcCobsTransport.h>
+#include <set>
+#include <string>
+#include <vector>
+#include "HostTest.h"
+#include "HostWire.h"
+
+typedef std::vector<std::string> Frames;
+
+// Both ends of one link, pumped until the wire is quiet
+struct Link {
+    HostWire ab, ba;
+    HostStream streamA, streamB;
+    RpcCobsTransport a, b;
+    Frames gotA, gotB;
+    
+    Link() : streamA(ba, ab, 0), streamB(ab, ba, 0), a(streamA), b(streamB) {}
+    
+    static void drain(RpcCobsTransport& t, Frames& got) {
+        while (t.available()) {
+            got.push_back(t.read().c_str());
+        }
+    }
+    
+    void pump() {
+        do {
+            drain(b, gotB);
+            drain(a, gotA);
+        } while (!ab.bytes.empty() || !ba.bytes.empty());
+    }
+    
+    void send(const char* payload) {
+        a.writeFrame(payload, strlen(payload));
+    }
+    
+    // Let every retry timer of a expire, then deliver what it resends
+    void expire() {
+        hostAdvanceMillis(RPC_COBS_RETRY_MS);
+        pump();
+    }
+};
+
+void testCleanDelivery() {
+    Link link;
+    link.send("one");
+    link.send("two");
+    link.send("three");
+    link.pump();
+    
+    CHECK_EQ(link.gotB.size(), 3);
+    if (link.gotB.size() == 3) {
+        CHECK_STR(link.gotB[0].c_str(), "one");
+        CHECK_STR(link.gotB[2].c_str(), "three");
+    }
+    CHECK_EQ(link.a.unacked(), 0);
+    CHECK_EQ(link.a.retransmits(), 0);
+    CHECK_EQ(link.b.crcErrors(), 0);
+}
+
+void testBinaryPayload() {
+    Link link;
+    const char payload[] = {'\x00', '\x01', '\x00', '\xff', '\x00'};
+    link.a.writeFrame(payload, sizeof(payload));
+    
+    size_t len = 0;
+    char* data = link.b.peekFrame(len);
+    CHECK_EQ(len, sizeof(payload));
+    CHECK(data && memcmp(data, payload, sizeof(payload)) == 0);
+    link.b.releaseFrame();
+    link.pump();
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testLongBlocks() {
+    Link link;
+    
+    // Lengths and zero positions around the 254-byte COBS block limit
+    // (the frame header shifts the payload by two bytes)
+    const size_t lengths[] = {254, 255, 256, 300};
+    const long zeros[] = {-1, 251, 252, 253, 254, 255, 256};
+    int sent = 0;
+    int intact = 0;
+    for (size_t length : lengths) {
+        for (long zero : zeros) {
+            if (zero >= (long)length) {
+                continue;
+            }
+            std::string payload(length, 'a');
+            for (size_t i = 0; i < length; i++) {
+                payload[i] = (char)(1 + i % 255);
+            }
+            if (zero >= 0) {
+                payload[zero] = '\0';
+                payload[length - 1] = '\0';
+            }
+            
+            link.a.writeFrame(payload.data(), payload.size());
+            sent++;
+            size_t len = 0;
+            char* data = link.b.peekFrame(len);
+            intact += data && len == length && memcmp(data, payload.data(), length) == 0;
+            link.b.releaseFrame();
+            link.pump();
+        }
+    }
+    
+    CHECK_EQ(intact, sent);
+    CHECK_EQ(link.b.crcErrors(), 0);
+    CHECK_EQ(link.a.retransmits(), 0);
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testCorruptedFrameNaked() {
+    Link link;
+    link.send("one");
+    link.streamA.corruptFrames(1);
+    link.send("two");
+    link.send("three");
+    link.pump();
+    
+    // The bad copy and the gap both NAK seq 1: it is resent once, at once
+    CHECK_EQ(link.b.crcErrors(), 1);
+    CHECK_EQ(link.a.retransmits(), 1);
+    CHECK_EQ(link.gotB.size(), 3);
+    if (link.gotB.size() == 3) {
+        CHECK_STR(link.gotB[0].c_str(), "one");
+        CHECK_STR(link.gotB[1].c_str(), "three");
+        CHECK_STR(link.gotB[2].c_str(), "two");
+    }
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testGapSelectiveRetransmit() {
+    Link link;
+    link.send("one");
+    link.pump();
+    
+    link.streamA.dropFrames(1);
+    link.send("two");
+    link.send("three");
+    link.send("four");
+    uint32_t sent = link.streamA.framesSent();
+    link.pump();
+    
+    // Only the missing frame goes out again, without waiting for a timer
+    CHECK_EQ(link.a.retransmits(), 1);
+    CHECK_EQ(link.streamA.framesSent() - sent, 1);
+    CHECK_EQ(link.b.crcErrors(), 0);
+    CHECK_EQ(link.gotB.size(), 4);
+    if (link.gotB.size() == 4) {
+        CHECK_STR(link.gotB[3].c_str(), "two");
+    }
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testLostFrameRetried() {
+    Link link;
+    link.streamA.dropFrames(1);
+    link.send("only");
+    link.pump();
+    
+    // Nothing follows it to reveal the gap: the retry timer recovers it
+    CHECK_EQ(link.gotB.size(), 0);
+    CHECK_EQ(link.a.unacked(), 1);
+    link.expire();
+    CHECK_EQ(link.gotB.size(), 1);
+    CHECK_EQ(link.a.retransmits(), 1);
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testLostAckNotDeliveredTwice() {
+    Link link;
+    link.streamB.dropFrames(1);
+    link.send("once");
+    link.pump();
+    CHECK_EQ(link.gotB.size(), 1);
+    CHECK_EQ(link.a.unacked(), 1);
+    
+    // The resend is a duplicate: ACKed again, not delivered
+    link.expire();
+    CHECK_EQ(link.gotB.size(), 1);
+    CHECK_EQ(link.a.retransmits(), 1);
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testDeadLinkGivesUp() {
+    Link link;
+    link.streamA.dropFrames(1000);
+    link.send("void");
+    
+    for (int i = 0; i < RPC_COBS_MAX_RETRIES + 1; i++) {
+        link.expire();
+    }
+    CHECK_EQ(link.a.retransmits(), RPC_COBS_MAX_RETRIES);
+    CHECK_EQ(link.a.lostFrames(), 1);
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testWindowOverflowEvictsOldest() {
+    Link link;
+    link.streamA.dropFrames(RPC_COBS_WINDOW + 1);
+    char payload[8];
+    for (int i = 0; i <= RPC_COBS_WINDOW; i++) {
+        snprintf(payload, sizeof(payload), "f%d", i);
+        link.send(payload);
+    }
+    
+    // The first frame was overwritten by the last one
+    CHECK_EQ(link.a.lostFrames(), 1);
+    CHECK_EQ(link.a.unacked(), RPC_COBS_WINDOW);
+    
+    // The link comes back: the window is resent, the evicted frame is not
+    // (the peer's NAK for it finds nothing to resend). The newest frame
+    // sits in the evicted slot and goes first, so the peer also NAKs the
+    // others: their extra copies are not delivered twice.
+    link.expire();
+    CHECK(link.a.retransmits() >= RPC_COBS_WINDOW);
+    CHECK_EQ(link.gotB.size(), RPC_COBS_WINDOW);
+    for (size_t i = 0; i < link.gotB.size(); i++) {
+        CHECK(link.gotB[i] != "f0");
+    }
+    CHECK_EQ(link.a.unacked(), 0);
+    
+    // The peer skips the hole and keeps receiving
+    link.send("next");
+    link.pump();
+    CHECK_EQ(link.gotB.size(), RPC_COBS_WINDOW + 1);
+    CHECK_EQ(link.a.unacked(), 0);
+}
+
+void testOversizeFrameDiscarded() {
+    Link link;
+    std::string junk(RPC_MAX_REQUEST_SIZE * 2, 'x');
+    link.streamA.inject(junk.data(), junk.size());
+    link.streamA.inject("", 1);
+    link.send("after");
+    link.pump();
+    
+    CHECK_EQ(link.b.takeDroppedFrames(), 1);
+    CHECK_EQ(link.gotB.size(), 1);
+}
+
+void testNoisySoak() {
+    const unsigned FRAMES = 500;
+    Link link;
+    link.streamA.setNoise(0.05, 0.002, 12345);
+    link.streamB.setNoise(0.05, 0.002, 54321);
+    
+    char payload[32];
+    for (unsigned i = 0; i < FRAMES; i++) {
+        snprintf(payload, sizeof(payload), "frame %u", i);
+        link.send(payload);
+        link.pump();
+        if (i % 2) {
+            link.expire();
+        }
+    }
+    for (int i = 0; i < RPC_COBS_MAX_RETRIES + 1; i++) {
+        link.expire();
+    }
+    
+    // Every payload intact and delivered at most once; whatever is
+    // missing was reported lost by the sender
+    std::set<unsigned> seen;
+    bool intact = true;
+    for (const std::string& frame : link.gotB) {
+        unsigned n;
+        char check[32];
+        if (sscanf(frame.c_str(), "frame %u", &n) != 1 || n >= FRAMES) {
+            intact = false;
+            continue;
+        }
+        snprintf(check, sizeof(check), "frame %u", n);
+        intact = intact && frame == check;
+        CHECK(seen.insert(n).second);
+    }
+    CHECK(intact);
+    CHECK(link.b.crcErrors() > 0);
+    CHECK(link.a.retransmits() > 0);
+    CHECK(FRAMES - seen.size() <= link.a.lostFrames());
+    CHECK_EQ(link.a.unacked(), 0);
+    printf("  %u/%u delivered, %u retransmits, %u CRC errors, %u lost\n", (unsigned)seen.size(), FRAMES,
+           (unsigned)link.a.retransmits(), (unsigned)link.b.crcErrors(), (unsigned)link.a.lostFrames());
+}
+
+int main() {
+    RUN_TEST(testCleanDelivery);
+    RUN_TEST(testBinaryPayload);
+    RUN_TEST(testLongBlocks);
+    RUN_TEST(testCorruptedFrameNaked);
+    RUN_TEST(testGapSelectiveRetransmit);
+    RUN_TEST(testLostFrameRetried);
+    RUN_TEST(testLostAckNotDeliveredTwice);
+    RUN_TEST(testDeadLinkGivesUp);
+    RUN_TEST(testWindowOverflowEvictsOldest);
+    RUN_TEST(testOversizeFrameDiscarded);
+    RUN_TEST(testNoisySoak);
+    return hostTestResult();
+}
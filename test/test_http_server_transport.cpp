@@ -0,0 +1,292 @@
+/**
+ * RPC Arduino Toolkit - HTTP Server Transport Tests (host)
+ * 
+ * RpcHttpServerTransportT over loopback sockets: keep-alive, pipelined
+ * requests, bodies split across segments, 413 for oversize bodies
+ * (and for bodies larger than the buffer given to readFrame()),
+ * idle timeout, Connection: close and the connection table limit.
+ */
+
+#include <RpcServer.h>
+#include <RpcHttpServerTransport.h>
+#include <string>
+#include "HostTest.h"
+#include "HostSocket.h"
+
+typedef RpcHttpServerTransportT<HostSocketServer, HostSocket> HostHttpTransport;
+
+struct Reply {
+    int status;
+    std::string head;
+    std::string body;
+};
+
+// Split the next response off the bytes a client received
+bool nextReply(std::string& received, Reply& reply) {
+    size_t end = received.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        return false;
+    }
+    reply.head = received.substr(0, end + 4);
+    reply.status = atoi(reply.head.c_str() + 9);
+    
+    size_t at = reply.head.find("Content-Length: ");
+    size_t length = at == std::string::npos ? 0 : strtoul(reply.head.c_str() + at + 16, nullptr, 10);
+    reply.body = received.substr(end + 4, length);
+    received.erase(0, end + 4 + length);
+    return true;
+}
+
+std::string post(const char* body, const char* headers = "") {
+    char head[128];
+    snprintf(head, sizeof(head), "POST / HTTP/1.1\r\nHost: rpc\r\n%sContent-Length: %u\r\n\r\n", headers,
+             (unsigned)strlen(body));
+    return std::string(head) + body;
+}
+
+std::string call(int n) {
+    char body[80];
+    snprintf(body, sizeof(body), "{\"jsonrpc\":\"2.0\",\"method\":\"twice\",\"params\":{\"n\":%d},\"id\":%d}", n, n);
+    return post(body);
+}
+
+// Result of a reply to call(n), -1 if it is not one
+int resultOf(const Reply& reply) {
+    StaticJsonDocument<256> doc;
+    if (reply.status != 200 || deserializeJson(doc, reply.body.c_str())) {
+        return -1;
+    }
+    return doc["result"].as<int>();
+}
+
+struct Fixture {
+    RpcServer<4> rpc;
+    HostSocketServer server;
+    HostHttpTransport http;
+    
+    Fixture() : http(server) {
+        rpc.addMethod("twice", [](JsonVariant params, JsonVariant result) {
+            result.set(params["n"].as<int>() * 2);
+        });
+    }
+    
+    // Serve everything that is ready
+    int serveAll() {
+        int served = 0;
+        while (rpc.serve(http)) {
+            served++;
+        }
+        http.read();  // Lets an unanswered request get its 204
+        return served;
+    }
+};
+
+void testKeepAlive() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    std::string received;
+    Reply reply;
+    
+    for (int n = 1; n <= 3; n++) {
+        peer.print(call(n).c_str());
+        CHECK_EQ(f.serveAll(), 1);
+        received += peer.take();
+        CHECK(nextReply(received, reply));
+        CHECK_EQ(resultOf(reply), 2 * n);
+        CHECK(reply.head.find("Connection: keep-alive") != std::string::npos);
+    }
+    CHECK(received.empty());
+    CHECK(peer.connected());
+    CHECK_EQ(f.http.connectionCount(), 1);
+}
+
+void testHeadIsOneWrite() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    peer.print(call(5).c_str());
+    f.serveAll();
+    
+    std::string received = peer.take();
+    std::vector<size_t> writes = peer.takePeerWrites();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK(!writes.empty());
+    if (!writes.empty()) {
+        CHECK_EQ(writes[0], reply.head.size());
+    }
+}
+
+void testPipelined() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    peer.print((call(1) + call(2) + call(3)).c_str());
+    
+    // One request at a time: the rest wait in the socket
+    CHECK(f.rpc.serve(f.http));
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 2);
+    CHECK(received.empty());
+    
+    CHECK_EQ(f.serveAll(), 2);
+    received = peer.take();
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 4);
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 6);
+}
+
+void testBodySplitAcrossSegments() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    std::string request = call(7);
+    size_t half = request.size() - 10;
+    
+    peer.print(request.substr(0, half).c_str());
+    CHECK_EQ(f.serveAll(), 0);
+    peer.print(request.substr(half).c_str());
+    CHECK_EQ(f.serveAll(), 1);
+    
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 14);
+}
+
+void testSlowSenderKeptOpen() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    peer.setReadDelay(1);  // The clock moves while the transport reads
+    std::string request = call(9);
+    size_t half = request.size() / 2;
+    
+    peer.print(request.substr(0, half).c_str());
+    CHECK_EQ(f.serveAll(), 0);
+    hostAdvanceMillis(RPC_HTTP_KEEPALIVE_TIMEOUT / 2);
+    CHECK_EQ(f.serveAll(), 0);
+    CHECK(peer.connected());
+    peer.print(request.substr(half).c_str());
+    CHECK_EQ(f.serveAll(), 1);
+    
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 18);
+    CHECK(peer.connected());
+}
+
+void testOversizeBody() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    std::string body(RPC_MAX_REQUEST_SIZE + 10, ' ');
+    peer.print(post(body.c_str()).c_str());
+    peer.print(call(4).c_str());
+    
+    // The body is skipped, the connection stays usable
+    CHECK_EQ(f.serveAll(), 1);
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(reply.status, 413);
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 8);
+    CHECK(received.empty());  // The 413 is the only answer to it
+    CHECK(peer.connected());
+}
+
+void testReadFrameTooLargeForBuffer() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    peer.print(call(2).c_str());
+    
+    char buf[16];
+    CHECK_EQ(f.http.readFrame(buf, sizeof(buf)), 0);
+    CHECK_EQ(f.http.takeDroppedFrames(), 1);
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(reply.status, 413);
+    CHECK(peer.connected());
+}
+
+void testNotificationGets204() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    peer.print(post("{\"jsonrpc\":\"2.0\",\"method\":\"twice\",\"params\":{\"n\":1}}").c_str());
+    f.serveAll();
+    
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(reply.status, 204);
+    CHECK(peer.connected());
+}
+
+void testIdleTimeout() {
+    Fixture f;
+    HostSocket idle = f.server.connect();
+    HostSocket busy = f.server.connect();
+    f.serveAll();
+    CHECK_EQ(f.http.connectionCount(), 2);
+    
+    hostAdvanceMillis(RPC_HTTP_KEEPALIVE_TIMEOUT / 2);
+    busy.print(call(1).c_str());
+    f.serveAll();
+    hostAdvanceMillis(RPC_HTTP_KEEPALIVE_TIMEOUT / 2);
+    f.serveAll();
+    
+    // Only the connection without traffic for the whole timeout is closed
+    CHECK(!idle.connected());
+    CHECK(busy.connected());
+    CHECK_EQ(f.http.connectionCount(), 1);
+}
+
+void testConnectionClose() {
+    Fixture f;
+    HostSocket peer = f.server.connect();
+    peer.print(post("{\"jsonrpc\":\"2.0\",\"method\":\"twice\",\"params\":{\"n\":3},\"id\":3}",
+                    "Connection: close\r\n").c_str());
+    f.serveAll();
+    
+    std::string received = peer.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(resultOf(reply), 6);
+    CHECK(reply.head.find("Connection: close") != std::string::npos);
+    CHECK(!peer.connected());
+    CHECK_EQ(f.http.connectionCount(), 0);
+}
+
+void testConnectionTableFull() {
+    Fixture f;
+    HostSocket peers[RPC_HTTP_MAX_CONNECTIONS];
+    for (int i = 0; i < RPC_HTTP_MAX_CONNECTIONS; i++) {
+        peers[i] = f.server.connect();
+        f.serveAll();
+    }
+    HostSocket extra = f.server.connect();
+    f.serveAll();
+    
+    std::string received = extra.take();
+    Reply reply;
+    CHECK(nextReply(received, reply));
+    CHECK_EQ(reply.status, 503);
+    CHECK(!extra.connected());
+    CHECK_EQ(f.http.connectionCount(), RPC_HTTP_MAX_CONNECTIONS);
+}
+
+int main() {
+    RUN_TEST(testKeepAlive);
+    RUN_TEST(testHeadIsOneWrite);
+    RUN_TEST(testPipelined);
+    RUN_TEST(testBodySplitAcrossSegments);
+    RUN_TEST(testSlowSenderKeptOpen);
+    RUN_TEST(testOversizeBody);
+    RUN_TEST(testReadFrameTooLargeForBuffer);
+    RUN_TEST(testNotificationGets204);
+    RUN_TEST(testIdleTimeout);
+    RUN_TEST(testConnectionClose);
+    RUN_TEST(testConnectionTableFull);
+    return hostTestResult();
+}
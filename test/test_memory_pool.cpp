@@ -0,0 +1,107 @@
+/**
+ * RPC Arduino Toolkit - Memory Pool Tests (host)
+ * 
+ * RpcMemoryPool stack discipline and exhaustion, and RpcDocument memory
+ * going back where it came from when the default pool changes while a
+ * document is alive.
+ */
+
+#define RPC_ENABLE_MEMORY_POOL 1
+#include <RpcMemoryPool.h>
+#include "HostAlloc.h"
+#include "HostTest.h"
+
+RpcStaticPool<4096> arena;
+RpcStaticPool<4096> other;
+
+void testStackReuse() {
+    void* a = arena.allocate(100);
+    void* b = arena.allocate(100);
+    CHECK(a && b);
+    CHECK(arena.owns(a) && arena.owns(b));
+    CHECK(!other.owns(a));
+    size_t used = arena.used();
+    
+    arena.deallocate(a);  // Below b: kept until b goes
+    CHECK_EQ(arena.used(), used);
+    arena.deallocate(b);
+    CHECK_EQ(arena.used(), 0);
+    CHECK(arena.highWaterMark() >= used);
+}
+
+void testExhaustion() {
+    CHECK(arena.allocate(8192) == nullptr);
+    void* all = arena.allocate(4000);
+    CHECK(all != nullptr);
+    CHECK(arena.allocate(100) == nullptr);
+    arena.deallocate(all);
+    CHECK_EQ(arena.used(), 0);
+}
+
+void testOwns() {
+    int local;
+    CHECK(!arena.owns(&local));
+    CHECK(!arena.owns(nullptr));
+    void* p = arena.allocate(16);
+    CHECK(arena.owns(p));
+    arena.deallocate(p);
+}
+
+void testHeapDocumentOutlivesSetDefault() {
+    RpcMemoryPool::setDefault(nullptr);
+    HostAllocScope heap;
+    {
+        RpcDocument<256> doc;
+        doc["a"] = 1;
+        CHECK(heap.allocations() >= 1);
+        
+        // Set while the heap document is alive: it must not be freed into the arena
+        RpcMemoryPool::setDefault(&arena);
+    }
+    if (hostAllocCountsMalloc()) {
+        CHECK_EQ(heap.frees(), heap.allocations());
+    }
+    CHECK_EQ(arena.used(), 0);
+    RpcMemoryPool::setDefault(nullptr);
+}
+
+void testPoolDocumentOutlivesSetDefault() {
+    RpcMemoryPool::setDefault(&arena);
+    {
+        RpcDocument<256> doc;
+        doc["a"] = 1;
+        CHECK(arena.used() >= 256);
+        
+        RpcMemoryPool::setDefault(&other);
+        RpcDocument<256> second;
+        CHECK(other.used() >= 256);
+        
+        RpcMemoryPool::setDefault(nullptr);
+    }
+    CHECK_EQ(arena.used(), 0);
+    CHECK_EQ(other.used(), 0);
+}
+
+void testPoolDocumentNoHeap() {
+    RpcMemoryPool::setDefault(&arena);
+    HostAllocScope heap;
+    {
+        RpcDocument<512> request;
+        RpcDocument<512> response;
+        request["method"] = "add";
+        response["result"] = 8;
+    }
+    CHECK_EQ(heap.allocations(), 0);
+    CHECK_EQ(arena.used(), 0);
+    RpcMemoryPool::setDefault(nullptr);
+}
+
+int main() {
+    RUN_TEST(testStackReuse);
+    RUN_TEST(testExhaustion);
+    RUN_TEST(testOwns);
+    RUN_TEST(testHeapDocumentOutlivesSetDefault);
+    RUN_TEST(testPoolDocumentOutlivesSetDefault);
+    RUN_TEST(testPoolDocumentNoHeap);
+    return hostTestResult();
+}
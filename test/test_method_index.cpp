@@ -0,0 +1,145 @@
+/**
+ * RPC Arduino Toolkit - Method Index Tests (host)
+ * 
+ * The FNV-1a open-addressed index of RpcServer: names sharing a probe
+ * chain (including one that wraps around the table), misses that walk a
+ * chain, removal from the middle of a chain, re-registration, and a full
+ * 128-method table.
+ */
+
+#include <RpcServer.h>
+#include <vector>
+#include "HostTest.h"
+
+// Reply value of method, or the error code (negative) it produced
+template<uint8_t N>
+int callMethod(RpcServer<N>& rpc, const char* method) {
+    char request[96];
+    char out[128];
+    snprintf(request, sizeof(request), "{\"jsonrpc\":\"2.0\",\"method\":\"%s\",\"id\":1}", method);
+    rpc.handleRequest(request, strlen(request), out, sizeof(out));
+    
+    StaticJsonDocument<256> reply;
+    deserializeJson(reply, out);
+    if (reply.containsKey("error")) {
+        return reply["error"]["code"].as<int>();
+    }
+    return reply["result"].as<int>();
+}
+
+template<uint8_t N>
+bool addValue(RpcServer<N>& rpc, const char* name, int value) {
+    return rpc.addMethod(name, [value](JsonVariant, JsonVariant result) {
+        result.set(value);
+    });
+}
+
+// Names "k<n>" whose index bucket (hash & mask) is bucket
+std::vector<std::string> namesInBucket(uint32_t mask, uint32_t bucket, size_t count) {
+    std::vector<std::string> names;
+    char name[16];
+    for (unsigned n = 0; names.size() < count; n++) {
+        snprintf(name, sizeof(name), "k%u", n);
+        if ((RpcHash::compute(name) & mask) == bucket) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+// RpcServer<4> has an 8-bucket index (twice MAX_METHODS, power of two)
+const uint32_t MASK4 = RpcHash::tableSize(2 * 4) - 1;
+
+void testSharedProbeChain() {
+    RpcServer<4> rpc;
+    std::vector<std::string> names = namesInBucket(MASK4, 3, 4);
+    
+    for (int i = 0; i < 3; i++) {
+        CHECK(addValue(rpc, names[i].c_str(), 100 + i));
+    }
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(callMethod(rpc, names[i].c_str()), 100 + i);
+    }
+    
+    // Same bucket, not registered: walks the whole chain and misses
+    CHECK_EQ(callMethod(rpc, names[3].c_str()), RPC_ERROR_METHOD_NOT_FOUND);
+}
+
+void testChainWrapsAround() {
+    RpcServer<4> rpc;
+    std::vector<std::string> names = namesInBucket(MASK4, MASK4, 3);
+    
+    for (int i = 0; i < 3; i++) {
+        CHECK(addValue(rpc, names[i].c_str(), 200 + i));
+    }
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(callMethod(rpc, names[i].c_str()), 200 + i);
+    }
+}
+
+void testRemoveFromChainAndReRegister() {
+    RpcServer<4> rpc;
+    std::vector<std::string> names = namesInBucket(MASK4, 5, 3);
+    for (int i = 0; i < 3; i++) {
+        addValue(rpc, names[i].c_str(), 300 + i);
+    }
+    
+    // The first and last stay reachable across the hole left in the chain
+    CHECK(rpc.removeMethod(names[1].c_str()));
+    CHECK(!rpc.removeMethod(names[1].c_str()));
+    CHECK_EQ(callMethod(rpc, names[0].c_str()), 300);
+    CHECK_EQ(callMethod(rpc, names[1].c_str()), RPC_ERROR_METHOD_NOT_FOUND);
+    CHECK_EQ(callMethod(rpc, names[2].c_str()), 302);
+    
+    // Back with a new handler, at the end of the chain
+    CHECK(addValue(rpc, names[1].c_str(), 311));
+    CHECK_EQ(callMethod(rpc, names[1].c_str()), 311);
+    CHECK_EQ(callMethod(rpc, names[2].c_str()), 302);
+    
+    // Removing the head of the chain
+    CHECK(rpc.removeMethod(names[0].c_str()));
+    CHECK_EQ(callMethod(rpc, names[1].c_str()), 311);
+    CHECK_EQ(callMethod(rpc, names[2].c_str()), 302);
+}
+
+void testFullTable() {
+    static RpcServer<128> rpc;
+    char name[16];
+    
+    for (int i = 0; i < 128; i++) {
+        snprintf(name, sizeof(name), "method%d", i);
+        CHECK(addValue(rpc, name, i));
+    }
+    CHECK(!addValue(rpc, "extra", 0));
+    
+    int wrong = 0;
+    for (int i = 0; i < 128; i++) {
+        snprintf(name, sizeof(name), "method%d", i);
+        wrong += callMethod(rpc, name) != i;
+    }
+    CHECK_EQ(wrong, 0);
+    
+    // Churn: every other method replaced by a new one
+    for (int i = 0; i < 128; i += 2) {
+        snprintf(name, sizeof(name), "method%d", i);
+        CHECK(rpc.removeMethod(name));
+        snprintf(name, sizeof(name), "renamed%d", i);
+        CHECK(addValue(rpc, name, 1000 + i));
+    }
+    wrong = 0;
+    for (int i = 0; i < 128; i++) {
+        snprintf(name, sizeof(name), i % 2 ? "method%d" : "renamed%d", i);
+        wrong += callMethod(rpc, name) != (i % 2 ? i : 1000 + i);
+        snprintf(name, sizeof(name), i % 2 ? "renamed%d" : "method%d", i);
+        wrong += callMethod(rpc, name) != RPC_ERROR_METHOD_NOT_FOUND;
+    }
+    CHECK_EQ(wrong, 0);
+}
+
+int main() {
+    RUN_TEST(testSharedProbeChain);
+    RUN_TEST(testChainWrapsAround);
+    RUN_TEST(testRemoveFromChainAndReRegister);
+    RUN_TEST(testFullTable);
+    return hostTestResult();
+}
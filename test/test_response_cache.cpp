@@ -0,0 +1,137 @@
+/**
+ * RPC Arduino Toolkit - Response Cache Tests (host)
+ * 
+ * RPC_ENABLE_CACHE: hits skip the handler and carry the caller's id,
+ * entries expire, are invalidated and cleared, and nothing is stored for
+ * error replies or responses that overflowed their document.
+ */
+
+#define RPC_ENABLE_CACHE 1
+#define RPC_CACHE_ENTRY_SIZE 2048  // Let only the overflow check turn results away
+#include <RpcServer.h>
+#include "HostTest.h"
+
+const uint32_t TTL = 1000;
+
+RpcServer<4> rpc;
+int calls = 0;
+
+struct Reply {
+    int code;      // Error code, 0 for a result
+    int result;
+    int id;
+};
+
+Reply call(const char* method, int id, int n = 0) {
+    char request[128];
+    char out[RPC_MAX_REQUEST_SIZE];
+    snprintf(request, sizeof(request), "{\"jsonrpc\":\"2.0\",\"method\":\"%s\",\"params\":{\"n\":%d},\"id\":%d}",
+             method, n, id);
+    rpc.handleRequest(request, strlen(request), out, sizeof(out));
+    
+    StaticJsonDocument<512> doc;
+    deserializeJson(doc, out);
+    Reply reply = {doc["error"]["code"] | 0, doc["result"] | -1, doc["id"] | -1};
+    return reply;
+}
+
+void setup() {
+    rpc.addMethod("counter", [](JsonVariant params, JsonVariant result) {
+        calls++;
+        result.set(params["n"].as<int>() * 10 + calls);
+    }, "", false, TTL);
+    
+    rpc.addMethod("failing", [](JsonVariant, JsonVariant) {
+        calls++;
+        throw 1;
+    }, "", false, TTL);
+    
+    // More elements than the response document holds: the partial
+    // array left in result must not be cached
+    rpc.addMethod("huge", [](JsonVariant, JsonVariant result) {
+        calls++;
+        JsonArray items = result.to<JsonArray>();
+        for (int i = 0; i < RPC_JSON_DOC_SIZE; i++) {
+            items.add(i);
+        }
+    }, "", false, TTL);
+}
+
+void reset() {
+    rpc.clearCache();
+    calls = 0;
+}
+
+void testHitSkipsHandler() {
+    reset();
+    Reply first = call("counter", 1, 2);
+    Reply second = call("counter", 2, 2);
+    
+    CHECK_EQ(calls, 1);
+    CHECK_EQ(first.result, 21);
+    CHECK_EQ(second.result, 21);
+    
+    // Other params are another entry
+    CHECK_EQ(call("counter", 3, 3).result, 32);
+    CHECK_EQ(calls, 2);
+}
+
+void testHitCarriesCallerId() {
+    reset();
+    CHECK_EQ(call("counter", 1).id, 1);
+    Reply hit = call("counter", 77);
+    CHECK_EQ(calls, 1);
+    CHECK_EQ(hit.id, 77);
+    CHECK_EQ(hit.code, 0);
+}
+
+void testExpiry() {
+    reset();
+    call("counter", 1);
+    hostAdvanceMillis(TTL - 1);
+    call("counter", 2);
+    CHECK_EQ(calls, 1);
+    
+    hostAdvanceMillis(1);
+    CHECK_EQ(call("counter", 3).result, 2);
+    CHECK_EQ(calls, 2);
+}
+
+void testInvalidateAndClear() {
+    reset();
+    call("counter", 1);
+    rpc.invalidateCache("counter");
+    call("counter", 2);
+    CHECK_EQ(calls, 2);
+    
+    call("counter", 3);
+    CHECK_EQ(calls, 2);
+    rpc.clearCache();
+    call("counter", 4);
+    CHECK_EQ(calls, 3);
+}
+
+void testErrorNotStored() {
+    reset();
+    CHECK_EQ(call("failing", 1).code, RPC_ERROR_INTERNAL);
+    CHECK_EQ(call("failing", 2).code, RPC_ERROR_INTERNAL);
+    CHECK_EQ(calls, 2);
+}
+
+void testOverflowNotStored() {
+    reset();
+    CHECK_EQ(call("huge", 1).code, RPC_ERROR_INTERNAL);
+    CHECK_EQ(call("huge", 2).code, RPC_ERROR_INTERNAL);
+    CHECK_EQ(calls, 2);
+}
+
+int main() {
+    setup();
+    RUN_TEST(testHitSkipsHandler);
+    RUN_TEST(testHitCarriesCallerId);
+    RUN_TEST(testExpiry);
+    RUN_TEST(testInvalidateAndClear);
+    RUN_TEST(testErrorNotStored);
+    RUN_TEST(testOverflowNotStored);
+    return hostTestResult();
+}
@@ -0,0 +1,52 @@
+/**
+ * RPC Arduino Toolkit - Safe-Mode Codec Tests (host)
+ * 
+ * RPC_ENABLE_SAFE_MODE output is valid JSON: control characters in
+ * strings are escaped (\uXXXX where there is no short form), measured
+ * correctly and restored on decode.
+ */
+
+#define RPC_ENABLE_SAFE_MODE 1
+#include <RpcCodec.h>
+#include <string>
+#include "HostTest.h"
+
+const char TEXT[] = "a\x01" "b\x1f" "c\n\"d";
+
+bool hasRawControl(const String& json) {
+    for (size_t i = 0; i < json.length(); i++) {
+        if ((uint8_t)json[i] < 0x20) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void testControlCharactersRoundTrip() {
+    StaticJsonDocument<512> doc;
+    doc["jsonrpc"] = "2.0";
+    doc["result"]["text"] = TEXT;
+    doc["result"]["list"][0] = TEXT;
+    doc["id"] = 1;
+    
+    String json;
+    RpcCodec::encode(doc, json, RPC_FORMAT_JSON);
+    CHECK(!hasRawControl(json));
+    CHECK(strstr(json.c_str(), "a\\u0001b\\u001fc\\n\\\"d") != nullptr);
+    CHECK_EQ(RpcCodec::measure(doc, RPC_FORMAT_JSON), json.length());
+    
+    char buffer[128];
+    size_t len = RpcCodec::encode(doc, buffer, sizeof(buffer), RPC_FORMAT_JSON);
+    CHECK_EQ(len, json.length());
+    CHECK_STR(buffer, json);
+    
+    StaticJsonDocument<512> back;
+    CHECK(!RpcCodec::decode(back, json.c_str(), json.length(), RPC_FORMAT_JSON));
+    CHECK_STR(back["result"]["text"].as<const char*>(), TEXT);
+    CHECK_STR(back["result"]["list"][0].as<const char*>(), TEXT);
+}
+
+int main() {
+    RUN_TEST(testControlCharactersRoundTrip);
+    return hostTestResult();
+}
@@ -0,0 +1,192 @@
+/**
+ * RPC Arduino Toolkit - Serial Transport Tests (host)
+ * 
+ * RpcSerialTransport over an in-memory link: oversize frames are
+ * answered with -32600 by the server and do not disturb the next
+ * request, length-prefixed framing resyncs after the link pauses in
+ * the middle of a frame, and readFrame() drops (never truncates) a
+ * frame larger than the caller's buffer.
+ */
+
+#include <RpcServer.h>
+#include <RpcSerialTransport.h>
+#include <string>
+#include <vector>
+#include "HostTest.h"
+#include "HostWire.h"
+
+struct Link {
+    HostWire toServer, toClient;
+    HostStream peer, serverSide;
+    RpcSerialTransport transport;
+    RpcServer<2> rpc;
+    
+    Link() : peer(toClient, toServer), serverSide(toServer, toClient), transport(serverSide) {
+        rpc.addMethod("twice", [](JsonVariant params, JsonVariant result) {
+            result.set(params["n"].as<int>() * 2);
+        });
+    }
+    
+    void send(const std::string& bytes) {
+        peer.inject(bytes.data(), bytes.size());
+    }
+    
+    // Lines the server wrote back
+    std::vector<std::string> replies() {
+        std::vector<std::string> lines(1);
+        while (peer.available()) {
+            char c = (char)peer.read();
+            if (c == '\n') {
+                lines.push_back("");
+            } else if (c != '\r') {
+                lines.back() += c;
+            }
+        }
+        lines.pop_back();
+        return lines;
+    }
+};
+
+// Length-prefixed frame as sent with a binary format
+std::string prefixed(const std::string& payload) {
+    std::string frame;
+    frame += (char)(payload.size() >> 8);
+    frame += (char)(payload.size() & 0xFF);
+    return frame + payload;
+}
+
+void testOversizeFrameAnswered() {
+    Link link;
+    std::string junk = "{\"jsonrpc\":\"2.0\",\"method\":\"twice\",\"params\":{\"s\":\"";
+    junk += std::string(RPC_MAX_REQUEST_SIZE, 'x') + "\"},\"id\":1}\n";
+    link.send(junk);
+    link.send("{\"jsonrpc\":\"2.0\",\"method\":\"twice\",\"params\":{\"n\":21},\"id\":2}\n");
+    
+    while (link.rpc.serve(link.transport)) {
+    }
+    
+    // The error comes first, then the reply to the request that followed
+    std::vector<std::string> replies = link.replies();
+    CHECK_EQ(replies.size(), 2);
+    if (replies.size() == 2) {
+        StaticJsonDocument<256> error, reply;
+        deserializeJson(error, replies[0].c_str());
+        deserializeJson(reply, replies[1].c_str());
+        CHECK_EQ(error["error"]["code"].as<int>(), RPC_ERROR_INVALID_REQ);
+        CHECK(error.containsKey("id") && error["id"].isNull());
+        CHECK_STR(error["error"]["message"].as<const char*>(), "Request too large");
+        CHECK_EQ(reply["result"].as<int>(), 42);
+        CHECK_EQ(reply["id"].as<int>(), 2);
+    }
+    CHECK_EQ(link.transport.droppedFrames(), 1);
+}
+
+void testOversizeFrameAnsweredByHandleRequest() {
+    Link link;
+    link.send(std::string(RPC_MAX_REQUEST_SIZE + 1, 'x') + "\n");
+    
+    String reply = link.rpc.handleRequest(link.transport);
+    CHECK(reply.isEmpty());
+    std::vector<std::string> replies = link.replies();
+    CHECK_EQ(replies.size(), 1);
+    if (replies.size() == 1) {
+        CHECK(replies[0].find("-32600") != std::string::npos);
+    }
+}
+
+void testBinaryOversizeSkipped() {
+    Link link;
+    link.transport.setFormat(RPC_FORMAT_MSGPACK);
+    link.send(prefixed(std::string(RPC_MAX_REQUEST_SIZE + 5, 'x')));
+    link.send(prefixed("next"));
+    
+    size_t len = 0;
+    char* frame = link.transport.peekFrame(len);
+    CHECK(frame && std::string(frame, len) == "next");
+    CHECK_EQ(link.transport.droppedFrames(), 1);
+}
+
+void testBinaryResyncAfterPause() {
+    Link link;
+    link.transport.setFormat(RPC_FORMAT_MSGPACK);
+    
+    // A frame cut short: without the pause, "next" would be read as its tail
+    link.send(prefixed(std::string(40, 'x')).substr(0, 12));
+    CHECK(!link.transport.frameAvailable());
+    hostAdvanceMillis(RPC_SERIAL_TIMEOUT);
+    link.send(prefixed("next"));
+    
+    CHECK(link.transport.frameAvailable());
+    CHECK_STR(std::string(link.transport.frame(), link.transport.frameLength()), "next");
+    CHECK_EQ(link.transport.droppedFrames(), 1);
+    link.transport.consumeFrame();
+    
+    // A slow sender pausing for less than the timeout keeps its frame
+    std::string frame = prefixed("slow frame");
+    link.send(frame.substr(0, 5));
+    CHECK(!link.transport.frameAvailable());
+    hostAdvanceMillis(RPC_SERIAL_TIMEOUT - 1);
+    link.send(frame.substr(5));
+    CHECK(link.transport.frameAvailable());
+    CHECK_STR(std::string(link.transport.frame(), link.transport.frameLength()), "slow frame");
+    CHECK_EQ(link.transport.droppedFrames(), 1);
+}
+
+void testReadFrameTooLargeForBuffer() {
+    Link link;
+    char buf[16];
+    link.send("{\"jsonrpc\":\"2.0\",\"method\":\"twice\"}\n");
+    link.send("[1,2]\n");
+    
+    CHECK_EQ(link.transport.readFrame(buf, sizeof(buf)), 0);
+    CHECK_EQ(link.transport.droppedFrames(), 1);
+    CHECK_EQ(link.transport.readFrame(buf, sizeof(buf)), 5);
+    CHECK_STR(buf, "[1,2]");
+    CHECK_EQ(link.transport.takeDroppedFrames(), 1);
+}
+
+// Only read(): exercises the default RpcTransport::readFrame()
+class StringTransport : public RpcTransport {
+public:
+    std::vector<std::string> frames;
+    
+    String read() override {
+        if (frames.empty()) {
+            return "";
+        }
+        String frame = frames.front().c_str();
+        frames.erase(frames.begin());
+        return frame;
+    }
+    
+    bool write(const String&) override {
+        return true;
+    }
+    
+    bool available() override {
+        return !frames.empty();
+    }
+};
+
+void testDefaultReadFrameTooLargeForBuffer() {
+    StringTransport transport;
+    transport.frames.push_back("0123456789abcdef");
+    transport.frames.push_back("0123456789abcde");
+    char buf[16];
+    
+    CHECK_EQ(transport.readFrame(buf, sizeof(buf)), 0);
+    CHECK_EQ(transport.readFrame(buf, sizeof(buf)), 15);
+    CHECK_STR(buf, "0123456789abcde");
+    CHECK_EQ(transport.takeDroppedFrames(), 1);
+    CHECK_EQ(transport.takeDroppedFrames(), 0);
+}
+
+int main() {
+    RUN_TEST(testOversizeFrameAnswered);
+    RUN_TEST(testOversizeFrameAnsweredByHandleRequest);
+    RUN_TEST(testBinaryOversizeSkipped);
+    RUN_TEST(testBinaryResyncAfterPause);
+    RUN_TEST(testReadFrameTooLargeForBuffer);
+    RUN_TEST(testDefaultReadFrameTooLargeForBuffer);
+    return hostTestResult();
+}
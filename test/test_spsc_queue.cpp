@@ -0,0 +1,154 @@
+/**
+ * RPC Arduino Toolkit - SPSC Queue Tests (host)
+ * 
+ * RpcSpscQueue semantics on one thread (full/empty, in-place slots,
+ * index wrap-around), then a producer and a consumer std::thread moving
+ * sequenced items and multi-word slots: every item arrives once, in
+ * order, and fully written.
+ */
+
+#include <RpcSpscQueue.h>
+#include <thread>
+#include "HostTest.h"
+
+void testFullAndEmpty() {
+    RpcSpscQueue<int, 4> queue;
+    int value = -1;
+    
+    CHECK(queue.empty());
+    CHECK(!queue.pop(value));
+    CHECK(queue.front() == nullptr);
+    
+    for (int i = 0; i < 4; i++) {
+        CHECK(queue.push(i));
+    }
+    CHECK_EQ(queue.size(), 4);
+    CHECK(!queue.push(4));
+    CHECK(queue.reserve() == nullptr);
+    
+    for (int i = 0; i < 4; i++) {
+        CHECK(queue.pop(value));
+        CHECK_EQ(value, i);
+    }
+    CHECK(queue.empty());
+}
+
+void testInPlaceSlots() {
+    RpcSpscQueue<int, 2> queue;
+    
+    int* slot = queue.reserve();
+    CHECK(slot != nullptr);
+    *slot = 42;
+    CHECK(queue.empty());  // Not visible before commit()
+    queue.commit();
+    
+    int* head = queue.front();
+    CHECK(head == slot);
+    CHECK_EQ(*head, 42);
+    CHECK_EQ(queue.size(), 1);  // Still owned until pop()
+    queue.pop();
+    CHECK(queue.empty());
+}
+
+void testWrapAround() {
+    RpcSpscQueue<uint32_t, 2> queue;
+    uint32_t value = 0;
+    bool ordered = true;
+    
+    // Far more items than slots: indices wrap, and the uint8_t size()
+    // keeps working as the 32-bit counters run on
+    for (uint32_t i = 0; i < 1000; i++) {
+        queue.push(i);
+        queue.push(i + 1);
+        ordered &= queue.size() == 2;
+        ordered &= queue.pop(value) && value == i;
+        ordered &= queue.pop(value) && value == i + 1;
+    }
+    CHECK(ordered);
+    CHECK(queue.empty());
+}
+
+void testThreadsInOrder() {
+    const uint32_t ITEMS = 1000000;
+    static RpcSpscQueue<uint32_t, 16> queue;
+    
+    std::thread producer([]() {
+        for (uint32_t i = 0; i < ITEMS; ) {
+            if (queue.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+    while (expected < ITEMS) {
+        uint32_t value;
+        if (queue.pop(value)) {
+            errors += value != expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    
+    CHECK_EQ(errors, 0);
+    CHECK(queue.empty());
+}
+
+// Slots larger than a word: the consumer must never see a half-written one
+struct Job {
+    uint32_t id;
+    uint32_t words[63];
+    uint32_t check;
+};
+
+void testThreadsInPlaceJobs() {
+    const uint32_t JOBS = 200000;
+    static RpcSpscQueue<Job, 2> queue;
+    
+    std::thread producer([]() {
+        for (uint32_t i = 0; i < JOBS; ) {
+            Job* job = queue.reserve();
+            if (job) {
+                job->id = i;
+                for (uint32_t w = 0; w < 63; w++) {
+                    job->words[w] = i * 63 + w;
+                }
+                job->check = ~i;
+                queue.commit();
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+    while (expected < JOBS) {
+        Job* job = queue.front();
+        if (job) {
+            errors += job->id != expected || job->check != ~expected;
+            errors += job->words[0] != expected * 63 || job->words[62] != expected * 63 + 62;
+            expected++;
+            queue.pop();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    
+    CHECK_EQ(errors, 0);
+}
+
+int main() {
+    RUN_TEST(testFullAndEmpty);
+    RUN_TEST(testInPlaceSlots);
+    RUN_TEST(testWrapAround);
+    RUN_TEST(testThreadsInOrder);
+    RUN_TEST(testThreadsInPlaceJobs);
+    return hostTestResult();
+}
@@ -0,0 +1,97 @@
+/**
+ * RPC Arduino Toolkit - Typed Method Tests (host)
+ * 
+ * addMethod<Ret(Args...)>() params handling: named and positional
+ * arguments are converted, anything else (missing, mistyped, unknown
+ * members, wrong count) is answered with -32602 and counted as an error
+ * reply in the method's metrics.
+ */
+
+#define RPC_ENABLE_METRICS 1
+#include <RpcServer.h>
+#include "HostTest.h"
+
+RpcServer<4> rpc;
+
+// Reply to {"method":"add","params":params,"id":1}
+String callAdd(const char* params) {
+    String request = "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":";
+    request += params;
+    request += ",\"id\":1}";
+    return rpc.handleRequest(request);
+}
+
+bool isInvalidParams(const String& reply) {
+    return reply.indexOf("-32602") >= 0;
+}
+
+void testNamed() {
+    CHECK_STR(callAdd("{\"a\":5,\"b\":3}"), "{\"jsonrpc\":\"2.0\",\"result\":8,\"id\":1}");
+    CHECK_STR(callAdd("{\"b\":3,\"a\":5}"), "{\"jsonrpc\":\"2.0\",\"result\":8,\"id\":1}");
+}
+
+void testPositional() {
+    CHECK_STR(callAdd("[5,3]"), "{\"jsonrpc\":\"2.0\",\"result\":8,\"id\":1}");
+    CHECK(isInvalidParams(callAdd("[5]")));
+    CHECK(isInvalidParams(callAdd("[5,3,1]")));
+}
+
+void testMissing() {
+    CHECK(isInvalidParams(callAdd("{\"a\":5}")));
+    CHECK(isInvalidParams(callAdd("{}")));
+}
+
+void testMistyped() {
+    CHECK(isInvalidParams(callAdd("{\"a\":\"5\",\"b\":3}")));
+}
+
+void testUnknownMember() {
+    CHECK(isInvalidParams(callAdd("{\"a\":5,\"b\":3,\"c\":1}")));
+    CHECK(isInvalidParams(callAdd("{\"a\":5,\"c\":3}")));
+}
+
+void testErrorsCounted() {
+    rpc.resetStats();
+    callAdd("{\"a\":5,\"b\":3}");
+    callAdd("{\"a\":5,\"b\":3,\"c\":1}");
+    callAdd("{\"a\":5}");
+    
+    const RpcMethodStats* stats = rpc.getMethodStats("add");
+    CHECK(stats != nullptr);
+    if (stats) {
+        CHECK_EQ(stats->calls, 3);
+        CHECK_EQ(stats->errors, 2);
+    }
+}
+
+void testLargeIntegerForDouble() {
+    String request = "{\"jsonrpc\":\"2.0\",\"method\":\"half\",\"params\":[18446744073709551614],\"id\":1}";
+    String reply = rpc.handleRequest(request);
+    CHECK(!isInvalidParams(reply));
+    
+    StaticJsonDocument<128> doc;
+    deserializeJson(doc, reply);
+    CHECK(doc["result"].as<double>() > 9.2e18);
+    
+    request = "{\"jsonrpc\":\"2.0\",\"method\":\"half\",\"params\":[-9223372036854775807],\"id\":1}";
+    reply = rpc.handleRequest(request);
+    CHECK(!isInvalidParams(reply));
+}
+
+int main() {
+    rpc.addMethod<int(int, int)>("add", [](int a, int b) {
+        return a + b;
+    }, "a", "b");
+    rpc.addMethod<double(double)>("half", [](double x) {
+        return x / 2;
+    }, "x");
+    
+    RUN_TEST(testNamed);
+    RUN_TEST(testPositional);
+    RUN_TEST(testMissing);
+    RUN_TEST(testMistyped);
+    RUN_TEST(testUnknownMember);
+    RUN_TEST(testErrorsCounted);
+    RUN_TEST(testLargeIntegerForDouble);
+    return hostTestResult();
+}
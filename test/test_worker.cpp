@@ -0,0 +1,236 @@
+/**
+ * RPC Arduino Toolkit - Threaded Server Tests (host)
+ * 
+ * RpcWorker driven by two std::threads, one calling step() (the worker
+ * task) and one calling runLoopHandlers() (the Arduino loop()): methods
+ * marked RPC_RUN_ON_LOOP run on the loop thread, their replies return to
+ * the transport the request came from, and a transport with a request
+ * parked in loop() is not read again until that reply is written.
+ * Oversize frames a transport drops are answered with -32600.
+ */
+
+#define RPC_ENABLE_THREADED 1
+#include <RpcWorker.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HostTest.h"
+
+// Frames in, replies out, both guarded: the test thread feeds and
+// inspects them while the worker thread owns the transport
+class QueueTransport : public RpcTransport {
+private:
+    mutable std::mutex lock;
+    std::deque<std::string> inbox;
+    std::vector<std::string> outbox;
+    std::vector<std::string> events;  // "read <frame>" / "write <reply>", in order
+    uint32_t dropped = 0;
+    
+public:
+    void push(const std::string& frame) {
+        std::lock_guard<std::mutex> guard(lock);
+        inbox.push_back(frame);
+    }
+    
+    size_t queued() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return inbox.size();
+    }
+    
+    std::vector<std::string> replies() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return outbox;
+    }
+    
+    std::vector<std::string> log() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return events;
+    }
+    
+    size_t readFrame(char* buf, size_t cap) override {
+        std::lock_guard<std::mutex> guard(lock);
+        if (inbox.empty()) {
+            return 0;
+        }
+        if (inbox.front().size() >= cap) {
+            inbox.pop_front();
+            dropped++;
+            return 0;
+        }
+        std::string frame = inbox.front();
+        inbox.pop_front();
+        memcpy(buf, frame.c_str(), frame.size() + 1);
+        events.push_back("read " + frame);
+        return frame.size();
+    }
+    
+    bool writeDocument(JsonVariantConst doc) override {
+        String text;
+        serializeJson(doc, text);
+        std::lock_guard<std::mutex> guard(lock);
+        outbox.push_back(text.c_str());
+        events.push_back(std::string("write ") + text.c_str());
+        return true;
+    }
+    
+    uint32_t takeDroppedFrames() override {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t count = dropped;
+        dropped = 0;
+        return count;
+    }
+    
+    String read() override {
+        return "";
+    }
+    
+    bool write(const String&) override {
+        return false;
+    }
+    
+    bool available() override {
+        return queued() > 0;
+    }
+};
+
+RpcServer<4> rpc;
+RpcWorker<4> worker(rpc);
+QueueTransport linkA, linkB;
+
+std::mutex threadsLock;
+std::thread::id loopHandlerThread, workerHandlerThread;
+std::atomic<bool> gateOpen(false);
+std::atomic<bool> stopping(false);
+std::atomic<uint32_t> workerSteps(0);
+
+std::string request(const char* method, int id) {
+    char text[96];
+    snprintf(text, sizeof(text), "{\"jsonrpc\":\"2.0\",\"method\":\"%s\",\"params\":{\"n\":%d},\"id\":%d}", method,
+             id, id);
+    return text;
+}
+
+// Spin (yielding: the sandbox may have a single CPU) until done() or 5 s
+template<typename Done>
+bool waitFor(Done done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void setup() {
+    // Held in loop() until the test opens the gate
+    rpc.addMethod("actuate", [](JsonVariant params, JsonVariant result) {
+        {
+            std::lock_guard<std::mutex> guard(threadsLock);
+            loopHandlerThread = std::this_thread::get_id();
+        }
+        while (!gateOpen) {
+            std::this_thread::yield();
+        }
+        result.set(params["n"].as<int>() * 100);
+    });
+    rpc.setMethodContext("actuate", RPC_RUN_ON_LOOP);
+    
+    rpc.addMethod("sense", [](JsonVariant params, JsonVariant result) {
+        {
+            std::lock_guard<std::mutex> guard(threadsLock);
+            workerHandlerThread = std::this_thread::get_id();
+        }
+        result.set(params["n"].as<int>());
+    });
+    
+    worker.attach(linkA);
+    worker.attach(linkB);
+}
+
+void testLoopMethodDeferred() {
+    linkA.push(request("actuate", 1));
+    linkA.push(request("sense", 2));
+    
+    std::thread workerThread([]() {
+        while (!stopping) {
+            if (!worker.step()) {
+                std::this_thread::yield();
+            }
+            workerSteps++;
+        }
+    });
+    std::thread loopThread([]() {
+        while (!stopping) {
+            worker.runLoopHandlers();
+            std::this_thread::yield();
+        }
+    });
+    
+    // The first request of A is parked in loop(); B keeps being served
+    CHECK(waitFor([]() { return linkA.queued() == 1; }));
+    linkB.push(request("sense", 3));
+    CHECK(waitFor([]() { return linkB.replies().size() == 1; }));
+    uint32_t steps = workerSteps;
+    CHECK(waitFor([steps]() { return workerSteps - steps > 100; }));
+    
+    // ...while A is not read again until its reply is written
+    CHECK_EQ(linkA.queued(), 1);
+    CHECK_EQ(linkA.replies().size(), 0);
+    
+    gateOpen = true;
+    CHECK(waitFor([]() { return linkA.replies().size() == 2; }));
+    std::thread::id loopId = loopThread.get_id();
+    std::thread::id workerId = workerThread.get_id();
+    stopping = true;
+    workerThread.join();
+    loopThread.join();
+    
+    CHECK(loopHandlerThread == loopId);
+    CHECK(workerHandlerThread == workerId);
+    
+    std::vector<std::string> log = linkA.log();
+    CHECK_EQ(log.size(), 4);
+    if (log.size() == 4) {
+        CHECK_STR(log[0], "read " + request("actuate", 1));
+        CHECK_STR(log[1], "write {\"jsonrpc\":\"2.0\",\"result\":100,\"id\":1}");
+        CHECK_STR(log[2], "read " + request("sense", 2));
+        CHECK_STR(log[3], "write {\"jsonrpc\":\"2.0\",\"result\":2,\"id\":2}");
+    }
+    
+    // B only got its own reply
+    std::vector<std::string> replies = linkB.replies();
+    CHECK_EQ(replies.size(), 1);
+    if (replies.size() == 1) {
+        CHECK_STR(replies[0], "{\"jsonrpc\":\"2.0\",\"result\":3,\"id\":3}");
+    }
+    CHECK_EQ(worker.pendingLoopRequests(), 0);
+}
+
+void testDroppedFrameAnswered() {
+    linkB.push(std::string(RPC_MAX_REQUEST_SIZE, 'x'));
+    linkB.push(request("sense", 4));
+    size_t before = linkB.replies().size();
+    for (int i = 0; i < 3; i++) {
+        worker.step();
+    }
+    
+    std::vector<std::string> replies = linkB.replies();
+    CHECK_EQ(replies.size(), before + 2);
+    if (replies.size() == before + 2) {
+        CHECK_STR(replies[before],
+                  "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32600,\"message\":\"Request too large\"},\"id\":null}");
+        CHECK_STR(replies[before + 1], "{\"jsonrpc\":\"2.0\",\"result\":4,\"id\":4}");
+    }
+}
+
+int main() {
+    setup();
+    RUN_TEST(testLoopMethodDeferred);
+    RUN_TEST(testDroppedFrameAnswered);
+    return hostTestResult();
+}
@@ -0,0 +1,156 @@
+/**
+ * RPC Arduino Toolkit - Zero Allocation Tests (host)
+ * 
+ * Steady-state requests must not touch the heap: the caller-buffer
+ * handleRequest(), handleDocument() and a server polling an
+ * RpcSerialTransport with in-situ parsing are checked with the host
+ * allocation counter, for results, errors, notifications and batches.
+ */
+
+#define RPC_ENABLE_IN_SITU 1
+#include <RpcServer.h>
+#include <RpcSerialTransport.h>
+#include "HostAlloc.h"
+#include "HostTest.h"
+
+RpcServer<4> rpc;
+char out[RPC_MAX_RESPONSE_SIZE];
+
+// Fixed-size serial line (a deque-based one would allocate as it grows)
+class RingStream : public Stream {
+private:
+    uint8_t data[1024];
+    size_t head;
+    size_t count;
+    
+public:
+    size_t sent;  // Bytes written (the replies)
+    
+    RingStream() : head(0), count(0), sent(0) {}
+    
+    void feed(const char* s) {
+        while (*s && count < sizeof(data)) {
+            data[(head + count++) % sizeof(data)] = (uint8_t)*s++;
+        }
+    }
+    
+    size_t write(uint8_t) override {
+        sent++;
+        return 1;
+    }
+    
+    int available() override {
+        return (int)count;
+    }
+    
+    int read() override {
+        if (count == 0) {
+            return -1;
+        }
+        int c = data[head];
+        head = (head + 1) % sizeof(data);
+        count--;
+        return c;
+    }
+    
+    int peek() override {
+        return count ? data[head] : -1;
+    }
+};
+
+RingStream line;
+RpcSerialTransport serial(line);
+
+const char* REQUESTS[] = {
+    "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":5,\"b\":3},\"id\":1}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[5,3],\"id\":2}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"mul\",\"params\":[5,3],\"id\":3}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":5,\"c\":3},\"id\":4}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":5,\"b\":3}}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":{\"text\":\"hello\"},\"id\":\"abc\"}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"add\"",
+    "[{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[1,2],\"id\":5},"
+    "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[3,4],\"id\":6}]",
+};
+const size_t REQUEST_COUNT = sizeof(REQUESTS) / sizeof(REQUESTS[0]);
+
+void testCounterLive() {
+    // The String API allocates its reply: proves the counter sees the heap
+    String request(REQUESTS[0]);
+    HostAllocScope heap;
+    String reply = rpc.handleRequest(request);
+    CHECK(heap.allocations() > 0);
+}
+
+void testBufferPath() {
+    for (size_t i = 0; i < REQUEST_COUNT; i++) {
+        const char* request = REQUESTS[i];
+        size_t len = strlen(request);
+        rpc.handleRequest(request, len, out, sizeof(out));  // Warm-up
+        
+        HostAllocScope heap;
+        for (int n = 0; n < 100; n++) {
+            rpc.handleRequest(request, len, out, sizeof(out));
+        }
+        if (heap.allocations() != 0) {
+            printf("  %s\n", request);
+        }
+        CHECK_EQ(heap.allocations(), 0);
+    }
+    
+    // The replies are still right
+    rpc.handleRequest(REQUESTS[0], strlen(REQUESTS[0]), out, sizeof(out));
+    CHECK_STR(out, "{\"jsonrpc\":\"2.0\",\"result\":8,\"id\":1}");
+}
+
+void testHandleDocument() {
+    RpcDocument<RPC_JSON_DOC_SIZE> request;
+    RpcDocument<RPC_JSON_DOC_SIZE> reply;
+    
+    HostAllocScope heap;
+    for (int n = 0; n < 100; n++) {
+        deserializeJson(request, REQUESTS[0]);
+        rpc.handleDocument(request, reply);
+    }
+    CHECK_EQ(heap.allocations(), 0);
+    CHECK_EQ(reply["result"].as<int>(), 8);
+}
+
+void testSerialPoll() {
+    rpc.attach(serial);
+    line.feed(REQUESTS[0]);
+    line.feed("\n");
+    rpc.poll(1000000);  // Warm-up
+    
+    HostAllocScope heap;
+    size_t sent = line.sent;
+    for (int n = 0; n < 100; n++) {
+        line.feed(REQUESTS[n % REQUEST_COUNT]);
+        line.feed("\n");
+        CHECK_EQ(rpc.poll(1000000), 1);
+    }
+    CHECK_EQ(heap.allocations(), 0);
+    CHECK(line.sent > sent);
+}
+
+int main() {
+    rpc.addMethod("add", [](JsonObjectConst params, JsonVariant result) {
+        result.set((params["a"] | 0) + (params["b"] | 0));
+    });
+    rpc.addMethod<int(int, int)>("mul", [](int a, int b) {
+        return a * b;
+    });
+    rpc.addMethod<const char*(const char*)>("echo", [](const char* text) {
+        return text;
+    }, "text");
+    
+    if (!hostAllocCountsMalloc()) {
+        printf("malloc is not counted on this platform: only operator new is checked\n");
+    }
+    
+    RUN_TEST(testCounterLive);
+    RUN_TEST(testBufferPath);
+    RUN_TEST(testHandleDocument);
+    RUN_TEST(testSerialPoll);
+    return hostTestResult();
+}